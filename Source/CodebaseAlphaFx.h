@@ -8,7 +8,28 @@
 
 #include <JuceHeader.h>
 
+// --- SIMD instruction set used by the block kernels; anything else falls back to scalar code
+#if defined(__AVX2__)
+ #include <immintrin.h>
+ #define ALPHA_FX_USE_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define ALPHA_FX_USE_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+ #include <arm_neon.h>
+ #define ALPHA_FX_USE_NEON 1
+#endif
+
+// --- virtual memory mirroring for CircularBuffer; other platforms use a plain heap buffer
+#if JUCE_MAC || JUCE_LINUX || JUCE_BSD
+ #include <sys/mman.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+ #define ALPHA_FX_HAS_MIRRORED_MEMORY 1
+#endif
+
 enum class generatorWaveform { kTriangle, kSin, kSaw };
+enum class interpolationType { kNone, kLinear, kLagrange, kHermite, kWindowedSinc };
 const double kPi = 3.14159;
 inline double unipolarToBipolar(double value)
 {
@@ -52,6 +73,211 @@ inline double doLinearInterpolation(double y1, double y2, double fractional_X)
     return fractional_X*y2 + (1.0 - fractional_X)*y1;
 }
 
+/** 4-point, 3rd order Lagrange weight of the tap at node for a read at fraction; nodes are -1, 0, 1, 2 */
+inline double lagrangeWeight(double fraction, int node)
+{
+    double weight = 1.0;
+
+    for (int other = -1; other <= 2; ++other)
+        if (other != node)
+            weight *= (fraction - other) / (double)(node - other);
+
+    return weight;
+}
+
+/** 4-point Catmull-Rom (Hermite) weight of the tap at node for a read at fraction; nodes are -1, 0, 1, 2 */
+inline double hermiteWeight(double t, int node)
+{
+    const double t2 = t * t;
+    const double t3 = t2 * t;
+
+    switch (node)
+    {
+        case -1: return 0.5 * (-t3 + 2.0 * t2 - t);
+        case 0:  return 0.5 * (3.0 * t3 - 5.0 * t2 + 2.0);
+        case 1:  return 0.5 * (-3.0 * t3 + 4.0 * t2 + t);
+        default: return 0.5 * (t3 - t2);
+    }
+}
+
+/** Blackman windowed sinc weight of the tap at node for a read at fraction; halfWidth is half the tap count */
+inline double windowedSincWeight(double fraction, int node, int halfWidth)
+{
+    const double x = fraction - node;
+
+    if (fabs(x) >= halfWidth)
+        return 0.0;
+
+    const double pi = juce::MathConstants<double>::pi;
+    const double sinc = x == 0.0 ? 1.0 : sin(pi * x) / (pi * x);
+    const double window = 0.42 + 0.5 * cos(pi * x / halfWidth) + 0.08 * cos(2.0 * pi * x / halfWidth);
+
+    return sinc * window;
+}
+
+/** polyphase coefficient table for a numTaps-point fractional delay, indexed by the quantized fraction.
+    Row order matches a delay line window read oldest first: coefficient j weights the tap at
+    node (numTaps / 2 - j), where node 0 is the integer delay and node 1 is one sample older. */
+template <int numTaps>
+struct FractionalDelayTable
+{
+    static constexpr int kNumPhases = 1024; ///< fractional resolution; row kNumPhases is fraction = 1.0
+
+    template <typename WeightFunction>
+    explicit FractionalDelayTable(WeightFunction weight)
+    {
+        for (int phase = 0; phase <= kNumPhases; ++phase)
+        {
+            const double fraction = phase / (double)kNumPhases;
+            double sum = 0.0;
+
+            for (int j = 0; j < numTaps; ++j)
+                sum += weight(fraction, numTaps / 2 - j);
+
+            // --- normalise for unity gain at DC
+            for (int j = 0; j < numTaps; ++j)
+                coefficients[phase][j] = (float)(weight(fraction, numTaps / 2 - j) / sum);
+        }
+    }
+
+    /** coefficient row for a fraction in [0.0, 1.0] */
+    template <typename FractionType>
+    const float* getCoefficients(FractionType fraction) const { return coefficients[(int)(fraction * kNumPhases + (FractionType)0.5)]; }
+
+    float coefficients[kNumPhases + 1][numTaps];
+};
+
+/** shared, lazily built tables; call once from a non-realtime thread (e.g. reset) before processing */
+inline const FractionalDelayTable<4>& getLagrangeTable()
+{
+    static const FractionalDelayTable<4> table(lagrangeWeight);
+    return table;
+}
+
+inline const FractionalDelayTable<4>& getHermiteTable()
+{
+    static const FractionalDelayTable<4> table(hermiteWeight);
+    return table;
+}
+
+inline const FractionalDelayTable<8>& getWindowedSincTable()
+{
+    static const FractionalDelayTable<8> table([] (double fraction, int node) { return windowedSincWeight(fraction, node, 4); });
+    return table;
+}
+
+/** thin wrapper over the native SIMD register for a sample type; all loads and stores are unaligned */
+template <typename T>
+struct AlphaVector;
+
+template <>
+struct AlphaVector<float>
+{
+#if ALPHA_FX_USE_AVX2
+    using Register = __m256;
+    static constexpr uint32_t size = 8;
+    static Register load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, Register v) { _mm256_storeu_ps(p, v); }
+    static Register broadcast(float v) { return _mm256_set1_ps(v); }
+    static Register add(Register a, Register b) { return _mm256_add_ps(a, b); }
+    static Register sub(Register a, Register b) { return _mm256_sub_ps(a, b); }
+    static Register mul(Register a, Register b) { return _mm256_mul_ps(a, b); }
+#elif ALPHA_FX_USE_SSE2
+    using Register = __m128;
+    static constexpr uint32_t size = 4;
+    static Register load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, Register v) { _mm_storeu_ps(p, v); }
+    static Register broadcast(float v) { return _mm_set1_ps(v); }
+    static Register add(Register a, Register b) { return _mm_add_ps(a, b); }
+    static Register sub(Register a, Register b) { return _mm_sub_ps(a, b); }
+    static Register mul(Register a, Register b) { return _mm_mul_ps(a, b); }
+#elif ALPHA_FX_USE_NEON
+    using Register = float32x4_t;
+    static constexpr uint32_t size = 4;
+    static Register load(const float* p) { return vld1q_f32(p); }
+    static void store(float* p, Register v) { vst1q_f32(p, v); }
+    static Register broadcast(float v) { return vdupq_n_f32(v); }
+    static Register add(Register a, Register b) { return vaddq_f32(a, b); }
+    static Register sub(Register a, Register b) { return vsubq_f32(a, b); }
+    static Register mul(Register a, Register b) { return vmulq_f32(a, b); }
+#else
+    using Register = float;
+    static constexpr uint32_t size = 1;
+    static Register load(const float* p) { return *p; }
+    static void store(float* p, Register v) { *p = v; }
+    static Register broadcast(float v) { return v; }
+    static Register add(Register a, Register b) { return a + b; }
+    static Register sub(Register a, Register b) { return a - b; }
+    static Register mul(Register a, Register b) { return a * b; }
+#endif
+};
+
+template <>
+struct AlphaVector<double>
+{
+#if ALPHA_FX_USE_AVX2
+    using Register = __m256d;
+    static constexpr uint32_t size = 4;
+    static Register load(const double* p) { return _mm256_loadu_pd(p); }
+    static void store(double* p, Register v) { _mm256_storeu_pd(p, v); }
+    static Register broadcast(double v) { return _mm256_set1_pd(v); }
+    static Register add(Register a, Register b) { return _mm256_add_pd(a, b); }
+    static Register sub(Register a, Register b) { return _mm256_sub_pd(a, b); }
+    static Register mul(Register a, Register b) { return _mm256_mul_pd(a, b); }
+#elif ALPHA_FX_USE_SSE2
+    using Register = __m128d;
+    static constexpr uint32_t size = 2;
+    static Register load(const double* p) { return _mm_loadu_pd(p); }
+    static void store(double* p, Register v) { _mm_storeu_pd(p, v); }
+    static Register broadcast(double v) { return _mm_set1_pd(v); }
+    static Register add(Register a, Register b) { return _mm_add_pd(a, b); }
+    static Register sub(Register a, Register b) { return _mm_sub_pd(a, b); }
+    static Register mul(Register a, Register b) { return _mm_mul_pd(a, b); }
+#elif ALPHA_FX_USE_NEON && defined(__aarch64__)
+    using Register = float64x2_t;
+    static constexpr uint32_t size = 2;
+    static Register load(const double* p) { return vld1q_f64(p); }
+    static void store(double* p, Register v) { vst1q_f64(p, v); }
+    static Register broadcast(double v) { return vdupq_n_f64(v); }
+    static Register add(Register a, Register b) { return vaddq_f64(a, b); }
+    static Register sub(Register a, Register b) { return vsubq_f64(a, b); }
+    static Register mul(Register a, Register b) { return vmulq_f64(a, b); }
+#else
+    using Register = double;
+    static constexpr uint32_t size = 1;
+    static Register load(const double* p) { return *p; }
+    static void store(double* p, Register v) { *p = v; }
+    static Register broadcast(double v) { return v; }
+    static Register add(Register a, Register b) { return a + b; }
+    static Register sub(Register a, Register b) { return a - b; }
+    static Register mul(Register a, Register b) { return a * b; }
+#endif
+};
+
+/** the register for a frame of numLanes values: AlphaVector<T>, unless that holds more lanes than
+    the frame, in which case a narrower register of the same instruction set */
+template <typename T, uint32_t numLanes, bool fitsNativeRegister = (AlphaVector<T>::size <= numLanes)>
+struct AlphaLaneVector : AlphaVector<T>
+{
+    static_assert(fitsNativeRegister, "no register narrow enough for this frame");
+};
+
+#if ALPHA_FX_USE_AVX2
+/** four floats in an SSE register, e.g. a 4-line frame in an AVX2 build */
+template <>
+struct AlphaLaneVector<float, 4, false>
+{
+    using Register = __m128;
+    static constexpr uint32_t size = 4;
+    static Register load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, Register v) { _mm_storeu_ps(p, v); }
+    static Register broadcast(float v) { return _mm_set1_ps(v); }
+    static Register add(Register a, Register b) { return _mm_add_ps(a, b); }
+    static Register sub(Register a, Register b) { return _mm_sub_ps(a, b); }
+    static Register mul(Register a, Register b) { return _mm_mul_ps(a, b); }
+};
+#endif
+
 class IAudioSignalGenerator
 {
 public:
@@ -64,8 +290,103 @@ public:
 
     /** render the generator output */
     virtual const SignalGenData renderAudioOutput() = 0;
+
+    /** render a block of generator output; normalOutput and quadPhaseOutput may be nullptr if not needed */
+    virtual void renderAudioBlock(float* normalOutput, float* quadPhaseOutput, uint32_t numSamples)
+    {
+        // --- default: one sample at a time
+        for (uint32_t i = 0; i < numSamples; ++i)
+        {
+            const SignalGenData output = renderAudioOutput();
+
+            if (normalOutput != nullptr) normalOutput[i] = (float)output.normalOutput;
+            if (quadPhaseOutput != nullptr) quadPhaseOutput[i] = (float)output.quadPhaseOutput_pos;
+        }
+    }
+};
+
+/** one cycle of an LFO waveform, band-limited by additive synthesis and shared by all LFOs;
+    phase conventions match LFO::renderAudioOutput( ): sin starts at 0 going up, triangle starts
+    at +1, saw ramps from -1 to +1 */
+struct LFOWavetable
+{
+    static constexpr int kTableSize = 2048;    ///< must be a power of 2
+    static constexpr int kNumHarmonics = 64;    ///< highest harmonic for triangle and saw
+
+    explicit LFOWavetable(generatorWaveform waveform)
+    {
+        const double twoPi = 2.0 * juce::MathConstants<double>::pi;
+        double peak = 0.0;
+
+        for (int i = 0; i < kTableSize; ++i)
+        {
+            const double phase = twoPi * i / kTableSize;
+            double value = 0.0;
+
+            if (waveform == generatorWaveform::kSin)
+            {
+                value = sin(phase);
+            }
+            else
+            {
+                for (int harmonic = 1; harmonic <= kNumHarmonics; ++harmonic)
+                {
+                    // --- Lanczos sigma factor keeps the Gibbs overshoot out of the modulation range
+                    const double x = juce::MathConstants<double>::pi * harmonic / (kNumHarmonics + 1);
+                    const double sigma = sin(x) / x;
+
+                    if (waveform == generatorWaveform::kTriangle)
+                    {
+                        if (harmonic % 2 == 1)
+                            value += sigma * cos(harmonic * phase) / (harmonic * harmonic);
+                    }
+                    else
+                    {
+                        value -= sigma * sin(harmonic * phase) / harmonic;
+                    }
+                }
+            }
+
+            table[i] = (float)value;
+            peak = juce::jmax(peak, fabs(value));
+        }
+
+        // --- normalise to +/-1.0 and add the guard point for interpolation
+        for (int i = 0; i < kTableSize; ++i)
+            table[i] = (float)(table[i] / peak);
+
+        table[kTableSize] = table[0];
+    }
+
+    /** linearly interpolated lookup; modulo is the phase in [0.0, +1.0] */
+    float lookup(double modulo) const
+    {
+        const double position = modulo * kTableSize;
+        const int index = (int)position;
+        const float fraction = (float)(position - index);
+        const int wrapped = index & (kTableSize - 1);
+
+        return table[wrapped] + fraction * (table[wrapped + 1] - table[wrapped]);
+    }
+
+    float table[kTableSize + 1];
 };
 
+/** shared wavetables, built together on first use; LFO::reset( ) does that off the audio thread */
+inline const LFOWavetable& getLFOWavetable(generatorWaveform waveform)
+{
+    static const LFOWavetable triangle(generatorWaveform::kTriangle);
+    static const LFOWavetable sine(generatorWaveform::kSin);
+    static const LFOWavetable saw(generatorWaveform::kSaw);
+
+    switch (waveform)
+    {
+        case generatorWaveform::kSin: return sine;
+        case generatorWaveform::kSaw: return saw;
+        default: return triangle;
+    }
+}
+
 class LFO : public IAudioSignalGenerator
 {
 public:
@@ -78,6 +399,9 @@ public:
         sampleRate = _sampleRate;
         phaseInc = lfoParameters.frequency_Hz / sampleRate;
 
+        // --- make sure the shared wavetables exist before the audio thread needs them
+        selectWaveform(lfoParameters.waveform);
+
         // --- timebase variables
         modCounter = 0.0;            ///< modulo counter [0.0, +1.0]
         modCounterQP = 0.25;        ///<Quad Phase modulo counter [0.0, +1.0]
@@ -101,11 +425,18 @@ public:
             // --- update phase inc based on osc freq and fs
             phaseInc = params.frequency_Hz / sampleRate;
 
+        if (params.waveform != lfoParameters.waveform)
+            selectWaveform(params.waveform);
+
         lfoParameters = params;
     }
 
-    /** render a new audio output structure */
-    const SignalGenData renderAudioOutput() {
+    /** render a new audio output structure; runs the kernel specialised for the current waveform */
+    const SignalGenData renderAudioOutput() { return (this->*renderOutputKernel)(); }
+
+    /** render a new audio output structure for one waveform, fixed at compile time */
+    template <generatorWaveform waveform>
+    const SignalGenData renderAudioOutputAs() {
         checkAndWrapModulo(modCounter, phaseInc);
 
         // --- QP output always follows location of current modulo; first set equal
@@ -115,10 +446,9 @@ public:
         advanceAndCheckWrapModulo(modCounterQP, 0.25);
 
         SignalGenData output;
-        generatorWaveform waveform = lfoParameters.waveform;
 
         // --- calculate the oscillator value
-        if (waveform == generatorWaveform::kSin)
+        if constexpr (waveform == generatorWaveform::kSin)
         {
             // --- calculate normal angle
             double angle = modCounter*2.0*kPi - kPi;
@@ -132,7 +462,7 @@ public:
             // --- calc QP output
             output.quadPhaseOutput_pos = parabolicSine(-angle);
         }
-        else if (waveform == generatorWaveform::kTriangle)
+        else if constexpr (waveform == generatorWaveform::kTriangle)
         {
             // triv saw
             output.normalOutput = unipolarToBipolar(modCounter);
@@ -146,7 +476,7 @@ public:
             // bipolar triagle
             output.quadPhaseOutput_pos = 2.0*fabs(output.quadPhaseOutput_pos) - 1.0;
         }
-        else if (waveform == generatorWaveform::kSaw)
+        else
         {
             output.normalOutput = unipolarToBipolar(modCounter);
             output.quadPhaseOutput_pos = unipolarToBipolar(modCounterQP);
@@ -162,7 +492,48 @@ public:
         return output;
     }
 
+    /** render a block of output from the band-limited wavetables; one table lookup per output sample.
+        NOTE: the tables are exact sine/band-limited shapes, so this differs very slightly from
+        renderAudioOutput( ), which uses the parabolic sine and trivial (aliasing) shapes */
+    virtual void renderAudioBlock(float* normalOutput, float* quadPhaseOutput, uint32_t numSamples) override
+    {
+        const LFOWavetable& table = *wavetable;
+
+        renderBlockWith(normalOutput, quadPhaseOutput, numSamples,
+                        [&table] (double modulo) { return table.lookup(modulo); });
+    }
+
+    /** control-rate rendering: advance the timebase by numSamples and return the normal output
+        (from the wavetable) at the new position */
+    float renderControlValue(uint32_t numSamples)
+    {
+        advanceModulo(modCounter, phaseInc * numSamples);
+
+        // --- wrap for either direction of travel
+        modCounter -= floor(modCounter);
+
+        return wavetable->lookup(modCounter);
+    }
+
 protected:
+    using OutputKernel = const SignalGenData (LFO::*)();
+
+    /** choose the wavetable and the renderAudioOutput( ) kernel; only on reset or a waveform change */
+    void selectWaveform(generatorWaveform waveform)
+    {
+        wavetable = &getLFOWavetable(waveform);
+
+        switch (waveform)
+        {
+            case generatorWaveform::kTriangle: renderOutputKernel = &LFO::renderAudioOutputAs<generatorWaveform::kTriangle>; break;
+            case generatorWaveform::kSaw:      renderOutputKernel = &LFO::renderAudioOutputAs<generatorWaveform::kSaw>; break;
+            default:                           renderOutputKernel = &LFO::renderAudioOutputAs<generatorWaveform::kSin>; break;
+        }
+    }
+
+    const LFOWavetable* wavetable = &getLFOWavetable(generatorWaveform::kTriangle);    ///< set by selectWaveform( ), matches the default waveform
+    OutputKernel renderOutputKernel = &LFO::renderAudioOutputAs<generatorWaveform::kTriangle>; ///< set by selectWaveform( )
+
     // --- parameters
     OscillatorParameters lfoParameters; ///< obejcgt parameters
 
@@ -220,6 +591,28 @@ protected:
     /** advanvce the modulo counter */
     inline void advanceModulo(double& moduloCounter, double phaseInc) { moduloCounter += phaseInc; }
 
+    /** run the timebase for a whole block, evaluating waveFunction on the normal and quad phase counters */
+    template <typename WaveFunction>
+    void renderBlockWith(float* normalOutput, float* quadPhaseOutput, uint32_t numSamples, WaveFunction waveFunction)
+    {
+        for (uint32_t i = 0; i < numSamples; ++i)
+        {
+            checkAndWrapModulo(modCounter, phaseInc);
+
+            if (normalOutput != nullptr)
+                normalOutput[i] = (float)waveFunction(modCounter);
+
+            if (quadPhaseOutput != nullptr)
+            {
+                modCounterQP = modCounter;
+                advanceAndCheckWrapModulo(modCounterQP, 0.25);
+                quadPhaseOutput[i] = (float)waveFunction(modCounterQP);
+            }
+
+            advanceModulo(modCounter, phaseInc);
+        }
+    }
+
     const double B = 4.0 / kPi;
     const double C = -4.0 / (kPi* kPi);
     const double P = 0.225;
@@ -232,6 +625,122 @@ protected:
     }
 };
 
+/** a block of memory whose pages are mapped twice, back to back, so that data[i] and data[i + size]
+    are the same memory; any window of up to size bytes starting inside the block is contiguous */
+class MirroredMemoryBlock
+{
+public:
+    MirroredMemoryBlock() {}                    /* C-TOR */
+    ~MirroredMemoryBlock() { release(); }        /* D-TOR */
+
+    MirroredMemoryBlock(const MirroredMemoryBlock&) = delete;
+    MirroredMemoryBlock& operator=(const MirroredMemoryBlock&) = delete;
+
+    /** allocate and map; numBytes must be a multiple of the page size
+        \return false if the platform cannot mirror this size, in which case nothing is allocated */
+    bool allocate(size_t numBytes)
+    {
+        release();
+
+    #if ALPHA_FX_HAS_MIRRORED_MEMORY
+        if (numBytes == 0 || numBytes % getPageSize() != 0)
+            return false;
+
+        const int fd = createSharedMemory(numBytes);
+
+        if (fd < 0)
+            return false;
+
+        // --- reserve address space for both copies, then map the same pages into each half
+        void* reserved = mmap(nullptr, 2 * numBytes, PROT_NONE, MAP_PRIVATE | MAP_ANON, -1, 0);
+        bool mapped = reserved != MAP_FAILED;
+
+        if (mapped)
+        {
+            char* base = static_cast<char*>(reserved);
+            mapped = mmap(base, numBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == base
+                  && mmap(base + numBytes, numBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == base + numBytes;
+
+            if (mapped)
+            {
+                data = base;
+                size = numBytes;
+            }
+            else
+            {
+                munmap(reserved, 2 * numBytes);
+            }
+        }
+
+        close(fd);
+        return mapped;
+    #else
+        juce::ignoreUnused(numBytes);
+        return false;
+    #endif
+    }
+
+    /** unmap both copies */
+    void release()
+    {
+    #if ALPHA_FX_HAS_MIRRORED_MEMORY
+        if (data != nullptr)
+            munmap(data, 2 * size);
+    #endif
+
+        data = nullptr;
+        size = 0;
+    }
+
+    /** start of the first copy; nullptr if not allocated */
+    void* getData() const { return data; }
+
+    /** size of ONE copy in bytes */
+    size_t getSize() const { return size; }
+
+    /** mapping granularity; mirrored blocks must be a multiple of this */
+    static size_t getPageSize()
+    {
+    #if ALPHA_FX_HAS_MIRRORED_MEMORY
+        return (size_t)sysconf(_SC_PAGESIZE);
+    #else
+        return 4096;
+    #endif
+    }
+
+private:
+#if ALPHA_FX_HAS_MIRRORED_MEMORY
+    /** anonymous shared memory object of numBytes; returns the file descriptor or -1 */
+    static int createSharedMemory(size_t numBytes)
+    {
+    #if JUCE_LINUX
+        int fd = memfd_create("AlphaFxCircularBuffer", 0);
+    #else
+        // --- no memfd on macOS/BSD: create a uniquely named object and unlink it straight away
+        static std::atomic<int> counter { 0 };
+        char name[32];
+        snprintf(name, sizeof(name), "/alphafx.%d.%d", (int)getpid(), counter++);
+
+        int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+
+        if (fd >= 0)
+            shm_unlink(name);
+    #endif
+
+        if (fd >= 0 && ftruncate(fd, (off_t)numBytes) != 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+
+        return fd;
+    }
+#endif
+
+    void* data = nullptr;    ///< first copy; the second copy follows at data + size
+    size_t size = 0;        ///< size of one copy in bytes
+};
+
 template <typename T>
 class CircularBuffer
 {
@@ -240,19 +749,20 @@ public:
     ~CircularBuffer() {}    /* D-TOR */
 
     /** flush buffer by resetting all values to 0.0 */
-    void flushBuffer(){ memset(&buffer[0], 0, bufferLength * sizeof(T)); }
+    void flushBuffer(){ memset(&buffer[0], 0, (bufferLength + wrapCopyLength) * sizeof(T)); }
 
     /** Create a buffer based on a target maximum in SAMPLES
-    //       do NOT call from realtime audio thread; do this prior to any processing */
-    void createCircularBuffer(unsigned int _bufferLength)
+    //       do NOT call from realtime audio thread; do this prior to any processing
+    //       useMirroredMemory maps the buffer twice so block reads/writes never need to wrap */
+    void createCircularBuffer(unsigned int _bufferLength, bool useMirroredMemory = false)
     {
         // --- find nearest power of 2 for buffer, and create
-        createCircularBufferPowerOfTwo((unsigned int)(pow(2, ceil(log(_bufferLength) / log(2)))));
+        createCircularBufferPowerOfTwo((unsigned int)(pow(2, ceil(log(_bufferLength) / log(2)))), useMirroredMemory);
     }
 
     /** Create a buffer based on a target maximum in SAMPLESwhere the size is
         pre-calculated as a power of two */
-    void createCircularBufferPowerOfTwo(unsigned int _bufferLengthPowerOfTwo)
+    void createCircularBufferPowerOfTwo(unsigned int _bufferLengthPowerOfTwo, bool useMirroredMemory = false)
     {
         // --- reset to top
         writeIndex = 0;
@@ -263,16 +773,161 @@ public:
         // --- save (bufferLength - 1) for use as wrapping mask
         wrapMask = bufferLength - 1;
 
-        // --- create new buffer
-        buffer.reset(new T[bufferLength]);
+        // --- create new buffer; mirroring needs whole pages, otherwise fall back to the heap
+        heapBuffer.reset();
+        mirroredBuffer.release();
+        wrapCopyLength = 0;
+
+        mirrored = useMirroredMemory && mirroredBuffer.allocate(bufferLength * sizeof(T));
+
+        if (mirrored)
+        {
+            buffer = static_cast<T*>(mirroredBuffer.getData());
+        }
+        else
+        {
+            heapBuffer.reset(new T[bufferLength]);
+            buffer = heapBuffer.get();
+        }
 
         // --- flush buffer
         flushBuffer();
     }
 
+    /** use external memory of _bufferLengthPowerOfTwo values, e.g. a line of a DelayMemoryArena;
+        the buffer does not own the memory. If _wrapCopyLength is not 0 the memory holds that many more
+        values, which the writes keep equal to the first ones, so read windows of up to _wrapCopyLength
+        values never wrap (see DelayMemoryArena::getWrapCopyLength( )). Flushes, but never allocates */
+    void attachToMemory(T* memory, unsigned int _bufferLengthPowerOfTwo, unsigned int _wrapCopyLength = 0)
+    {
+        jassert(juce::isPowerOfTwo(_bufferLengthPowerOfTwo));
+        jassert(_wrapCopyLength <= _bufferLengthPowerOfTwo);
+
+        heapBuffer.reset();
+        mirroredBuffer.release();
+
+        buffer = memory;
+        mirrored = false;
+        wrapCopyLength = _wrapCopyLength;
+        writeIndex = 0;
+        bufferLength = _bufferLengthPowerOfTwo;
+        wrapMask = bufferLength - 1;
+
+        flushBuffer();
+    }
+
+    /** true if the buffer memory is mirrored, i.e. every window up to bufferLength is contiguous */
+    bool isMirrored() const { return mirrored; }
+
+    /** write numSamples values, oldest first; equivalent to numSamples calls to writeBuffer( ) */
+    void writeBlock(const T* input, unsigned int numSamples)
+    {
+        jassert(numSamples <= bufferLength);
+
+        if (isMirrored())
+        {
+            // --- the tail of the copy lands in the mirror, i.e. at the top of the buffer
+            memcpy(buffer + writeIndex, input, numSamples * sizeof(T));
+        }
+        else
+        {
+            const unsigned int firstPart = juce::jmin(numSamples, bufferLength - writeIndex);
+            memcpy(buffer + writeIndex, input, firstPart * sizeof(T));
+            memcpy(buffer, input + firstPart, (numSamples - firstPart) * sizeof(T));
+
+            updateWrapCopy(writeIndex, firstPart);
+            updateWrapCopy(0, numSamples - firstPart);
+        }
+
+        writeIndex = (writeIndex + numSamples) & wrapMask;
+    }
+
+    /** read the numSamples values that readBuffer(delayInSamples) will return while the next
+        numSamples values are written; requires delayInSamples >= numSamples so that all of
+        them already exist. output[0] is the oldest. */
+    void readBlock(int delayInSamples, T* output, unsigned int numSamples) const
+    {
+        jassert(numSamples <= bufferLength);
+
+        const unsigned int readIndex = (writeIndex - delayInSamples) & wrapMask;
+
+        if (isMirrored())
+        {
+            memcpy(output, buffer + readIndex, numSamples * sizeof(T));
+        }
+        else
+        {
+            const unsigned int firstPart = juce::jmin(numSamples, bufferLength - readIndex);
+            memcpy(output, buffer + readIndex, firstPart * sizeof(T));
+            memcpy(output + firstPart, buffer, (numSamples - firstPart) * sizeof(T));
+        }
+    }
+
+    /** batched fractional read: output[i] is what readBuffer(delaysInFractionalSamples[i]) will return
+        after i + 1 of the next numSamples writes, i.e. every delay must reach back past the block.
+        The interpolator is chosen once for the whole block. */
+    void readBlock(const T* delaysInFractionalSamples, T* output, unsigned int numSamples) const
+    {
+        switch (interpolation)
+        {
+            case interpolationType::kNone:
+                return readBlockAs<interpolationType::kNone>(delaysInFractionalSamples, output, numSamples);
+            case interpolationType::kLagrange:
+                return readBlockAs<interpolationType::kLagrange>(delaysInFractionalSamples, output, numSamples);
+            case interpolationType::kHermite:
+                return readBlockAs<interpolationType::kHermite>(delaysInFractionalSamples, output, numSamples);
+            case interpolationType::kWindowedSinc:
+                return readBlockAs<interpolationType::kWindowedSinc>(delaysInFractionalSamples, output, numSamples);
+            default:
+                return readBlockAs<interpolationType::kLinear>(delaysInFractionalSamples, output, numSamples);
+        }
+    }
+
+    /** readBlock( ) with the interpolator fixed at compile time; type must be the one set with
+        setInterpolationType( ) unless it is kNone or kLinear, which need no table */
+    template <interpolationType type>
+    void readBlockAs(const T* delaysInFractionalSamples, T* output, unsigned int numSamples) const
+    {
+        for (unsigned int i = 0; i < numSamples; ++i)
+            output[i] = readBufferAs<type>(delaysInFractionalSamples[i] - (T)(i + 1));
+    }
+
+    /** peak magnitude of the last numSamples values written; vectorised, no copy */
+    T getRecentPeak(unsigned int numSamples) const
+    {
+        numSamples = juce::jmin(numSamples, bufferLength);
+
+        const unsigned int readIndex = (writeIndex - numSamples) & wrapMask;
+        const unsigned int firstPart = juce::jmin(numSamples, bufferLength - readIndex);
+
+        auto range = juce::FloatVectorOperations::findMinAndMax(buffer + readIndex, (int)firstPart);
+
+        if (firstPart < numSamples)
+            range = range.getUnionWith(juce::FloatVectorOperations::findMinAndMax(buffer, (int)(numSamples - firstPart)));
+
+        return juce::jmax(-range.getStart(), range.getEnd());
+    }
+
+    /** zero-copy version of readBlock( ): a pointer to the window in the buffer itself, or nullptr
+        if the window wraps around further than the buffer is mirrored or copied (see attachToMemory( ));
+        valid until the next write */
+    const T* getReadPointer(int delayInSamples, unsigned int numSamples) const
+    {
+        const unsigned int readIndex = (writeIndex - delayInSamples) & wrapMask;
+
+        if (isMirrored() || readIndex + numSamples <= bufferLength + wrapCopyLength)
+            return buffer + readIndex;
+
+        return nullptr;
+    }
+
     /** write a value into the buffer; this overwrites the previous oldest value in the buffer */
     void writeBuffer(T input)
     {
+        // --- keep the copy of the first values after the end up to date
+        if (writeIndex < wrapCopyLength)
+            buffer[writeIndex + bufferLength] = input;
+
         // --- write and increment index counter
         buffer[writeIndex++] = input;
 
@@ -281,7 +936,7 @@ public:
     }
 
     /** read an arbitrary location that is delayInSamples old */
-    T readBuffer(int delayInSamples)//, bool readBeforeWrite = true)
+    T readBuffer(int delayInSamples) const//, bool readBeforeWrite = true)
     {
         // --- subtract to make read index
         //     note: -1 here is because we read-before-write,
@@ -296,86 +951,607 @@ public:
     }
 
     /** read an arbitrary location that includes a fractional sample */
-    T readBuffer(double delayInFractionalSamples)
+    T readBuffer(double delayInFractionalSamples) const
     {
-        // --- truncate delayInFractionalSamples and read the int part
-        T y1 = readBuffer((int)delayInFractionalSamples);
+        const T delay = (T)delayInFractionalSamples;
+
+        switch (interpolation)
+        {
+            case interpolationType::kNone:
+                return readBufferAs<interpolationType::kNone>(delay);
+            case interpolationType::kLagrange:
+                return readBufferAs<interpolationType::kLagrange>(delay);
+            case interpolationType::kHermite:
+                return readBufferAs<interpolationType::kHermite>(delay);
+            case interpolationType::kWindowedSinc:
+                return readBufferAs<interpolationType::kWindowedSinc>(delay);
+            default:
+                return readBufferAs<interpolationType::kLinear>(delay);
+        }
+    }
 
-        // --- if no interpolation, just return value
-        if (!interpolate) return y1;
+    /** readBuffer( ) with the interpolator fixed at compile time, so there is no branch on the
+        runtime type; for use in kernels specialised on interpolationType (see readBlockAs( )).
+        The delay is in the sample type, so no conversion to double happens per read */
+    template <interpolationType type>
+    T readBufferAs(T delayInFractionalSamples) const
+    {
+        if constexpr (type == interpolationType::kNone)
+            return readBuffer((int)delayInFractionalSamples);
+        else if constexpr (type == interpolationType::kLagrange)
+            return readBufferWithTable(delayInFractionalSamples, *lagrangeTable);
+        else if constexpr (type == interpolationType::kHermite)
+            return readBufferWithTable(delayInFractionalSamples, *hermiteTable);
+        else if constexpr (type == interpolationType::kWindowedSinc)
+            return readBufferWithTable(delayInFractionalSamples, *windowedSincTable);
+        else
+            return readBufferLinear(delayInFractionalSamples);
+    }
 
-        // --- else do interpolation
-        //
-        // --- read the sample at n+1 (one sample OLDER)
-        T y2 = readBuffer((int)delayInFractionalSamples + 1);
+    /** enable or disable interpolation; usually used for diagnostics or in algorithms that require strict integer samples times */
+    void setInterpolate(bool b) { setInterpolationType(b ? interpolationType::kLinear : interpolationType::kNone); }
 
-        // --- get fractional part
-        double fraction = delayInFractionalSamples - (int)delayInFractionalSamples;
+    /** choose the fractional delay interpolator; builds the shared coefficient tables on first use,
+        so do NOT call for the first time from the realtime audio thread */
+    void setInterpolationType(interpolationType type)
+    {
+        interpolation = type;
 
-        // --- do the interpolation (you could try different types here)
-        return doLinearInterpolation(y1, y2, fraction);
+        if (type == interpolationType::kLagrange && lagrangeTable == nullptr) lagrangeTable = &getLagrangeTable();
+        if (type == interpolationType::kHermite && hermiteTable == nullptr) hermiteTable = &getHermiteTable();
+        if (type == interpolationType::kWindowedSinc && windowedSincTable == nullptr) windowedSincTable = &getWindowedSincTable();
     }
 
-    /** enable or disable interpolation; usually used for diagnostics or in algorithms that require strict integer samples times */
-    void setInterpolate(bool b) { interpolate = b; }
+    interpolationType getInterpolationType() const { return interpolation; }
 
 private:
-    std::unique_ptr<T[]> buffer = nullptr;    ///< smart pointer will auto-delete
+    T* buffer = nullptr;                ///< points into heapBuffer, mirroredBuffer or attached memory
+    std::unique_ptr<T[]> heapBuffer = nullptr;    ///< smart pointer will auto-delete
+    MirroredMemoryBlock mirroredBuffer;    ///< used instead of heapBuffer when mirroring is requested
+    bool mirrored = false;                ///< buffer[i] and buffer[i + bufferLength] are the same value
+    unsigned int wrapCopyLength = 0;    ///< values after the end that repeat the first ones (attached memory only)
     unsigned int writeIndex = 0;        ///> write index
     unsigned int bufferLength = 1024;    ///< must be nearest power of 2
     unsigned int wrapMask = 1023;        ///< must be (bufferLength - 1)
-    bool interpolate = true;            ///< interpolation (default is ON)
-};
+    interpolationType interpolation = interpolationType::kLinear; ///< interpolation (default is linear)
 
-struct AlphaSimpleDelayParameters
-{
-    AlphaSimpleDelayParameters& operator= (const AlphaSimpleDelayParameters& parameters)
+    const FractionalDelayTable<4>* lagrangeTable = nullptr;        ///< set by setInterpolationType( )
+    const FractionalDelayTable<4>* hermiteTable = nullptr;        ///< set by setInterpolationType( )
+    const FractionalDelayTable<8>* windowedSincTable = nullptr;    ///< set by setInterpolationType( )
+
+    /** copy the values written at [start, start + numSamples) that have a copy after the end */
+    void updateWrapCopy(unsigned int start, unsigned int numSamples)
     {
-        if (this != &parameters)
-        {
-            wetDryMix = parameters.wetDryMix;
-            feedback = parameters.feedback;
-            delay = parameters.delay;
-        }
+        if (start < wrapCopyLength)
+            memcpy(buffer + bufferLength + start, buffer + start, (juce::jmin(start + numSamples, wrapCopyLength) - start) * sizeof(T));
+    }
 
-        return *this;
+    /** pointer to numSamples contiguous values, oldest first, whose oldest is delayInSamples - 1 old;
+        copies into scratch only if the window wraps in a non-mirrored buffer */
+    const T* getTapWindow(int delayInSamples, unsigned int numSamples, T* scratch) const
+    {
+        if (const T* window = getReadPointer(delayInSamples, numSamples))
+            return window;
+
+        readBlock(delayInSamples, scratch, numSamples);
+        return scratch;
     }
 
-    double wetDryMix = 0.5;
-    double feedback = 0.0;
-    double delay = 0.5; // in seconds
-};
+    /** linear interpolation; both taps come from one window instead of two masked reads */
+    T readBufferLinear(T delayInFractionalSamples) const
+    {
+        const int readDelay = (int)delayInFractionalSamples;
+        const T fraction = delayInFractionalSamples - (T)readDelay;
 
-class IAudioSignalProcessor
-{
-public:
-    // --- pure virtual, derived classes must implement or will not compile
-    //     also means this is a pure abstract base class and is incomplete,
-    //     so it can only be used as a base class
-    //
-    /** initialize the object with the new sample rate */
-    virtual bool reset(double _sampleRate) = 0;
+        T scratch[2];
+        const T* taps = getTapWindow(readDelay + 2, 2, scratch);
 
-    /** process one sample in and out */
-    virtual double processAudioSample(double xn) = 0;
+        // --- taps[1] is the int part, taps[0] the sample at n+1 (one sample OLDER)
+        return taps[1] + fraction * (taps[0] - taps[1]);
+    }
 
-    /** return true if the derived object can process a frame, false otherwise */
-    virtual bool canProcessAudioFrame() = 0;
+    /** numTaps-point interpolation with coefficients from a polyphase table */
+    template <int numTaps>
+    T readBufferWithTable(T delayInFractionalSamples, const FractionalDelayTable<numTaps>& table) const
+    {
+        const int readDelay = (int)delayInFractionalSamples;
 
-    /** set or change the sample rate; normally this is done during reset( ) but may be needed outside of initialzation */
-    virtual void setSampleRate(double _sampleRate) {}
+        // --- the newest tap sits numTaps / 2 - 1 samples after the int part; too short a delay
+        //     would read samples that have not been written yet
+        if (readDelay < numTaps / 2 - 1)
+            return readBufferLinear(delayInFractionalSamples);
 
-    /** switch to enable/disable the aux input */
-    virtual void enableAuxInput(bool enableAuxInput) {}
+        T scratch[numTaps];
+        const T* taps = getTapWindow(readDelay + numTaps / 2 + 1, numTaps, scratch);
+        const float* coefficients = table.getCoefficients(delayInFractionalSamples - (T)readDelay);
 
-    /** for processing objects with a sidechain input or other necessary aux input
-            the return value is optional and will depend on the subclassed object */
-    virtual double processAuxInputAudioSample(double xn)
+        T output = 0;
+
+        for (int j = 0; j < numTaps; ++j)
+            output += taps[j] * coefficients[j];
+
+        return output;
+    }
+};
+
+/** one allocation for all the delay lines of a processor, sized up front for the longest delay at the
+    highest sample rate it supports; every reset( ) carves its lines out of it again at the length the
+    current sample rate needs, so changing rate or block size never touches the heap. The lines sit
+    back to back, so all of a processor's delay memory is one contiguous range.
+    NOTE: the line length depends on the sample rate, so lines cannot be mirrored (see CircularBuffer);
+    instead each line can be followed by a copy of its first values, so short read windows never wrap */
+template <typename T>
+class DelayMemoryArena
+{
+public:
+    static constexpr double kMaximumSampleRate = 192000.0;    ///< sized for this; higher rates grow the arena once
+
+    DelayMemoryArena() {}        /* C-TOR */
+    ~DelayMemoryArena() {}        /* D-TOR */
+
+    /** lay out numLines lines of maxDelaySeconds (plus guardSamples) at sampleRate, each followed by
+        room for a copy of its first wrapCopySamples values; allocates only the first time, or if
+        sampleRate is above kMaximumSampleRate and the arena has to grow.
+        Pages of the arena that the current rate does not use are never touched */
+    void prepare(uint32_t numLines, double maxDelaySeconds, double sampleRate, unsigned int guardSamples = 1,
+                 unsigned int wrapCopySamples = 0)
+    {
+        const size_t capacityNeeded = (size_t)numLines
+                                    * (getLineLength(juce::jmax(sampleRate, kMaximumSampleRate), maxDelaySeconds, guardSamples) + wrapCopySamples);
+
+        if (capacityNeeded > capacity)
+        {
+            memory.reset(new T[capacityNeeded]);
+            capacity = capacityNeeded;
+        }
+
+        lineLength = getLineLength(sampleRate, maxDelaySeconds, guardSamples);
+        wrapCopyLength = juce::jmin(wrapCopySamples, lineLength);
+        numPreparedLines = numLines;
+    }
+
+    /** start of line index; lineLength values plus the wrap copy, not cleared (CircularBuffer::attachToMemory( ) flushes) */
+    T* getLine(uint32_t index) const
+    {
+        jassert(index < numPreparedLines);
+        return memory.get() + (size_t)index * (lineLength + wrapCopyLength);
+    }
+
+    /** power of two length of every line, as laid out by the last prepare( ) */
+    unsigned int getLineLength() const { return lineLength; }
+
+    /** values after every line that are kept equal to its first ones, for CircularBuffer::attachToMemory( ) */
+    unsigned int getWrapCopyLength() const { return wrapCopyLength; }
+
+    /** smallest power of two holding maxDelaySeconds plus guardSamples at sampleRate */
+    static unsigned int getLineLength(double sampleRate, double maxDelaySeconds, unsigned int guardSamples)
+    {
+        return (unsigned int)juce::nextPowerOfTwo((int)(sampleRate * maxDelaySeconds) + (int)guardSamples);
+    }
+
+private:
+    std::unique_ptr<T[]> memory = nullptr;    ///< smart pointer will auto-delete
+    size_t capacity = 0;                    ///< in values
+    unsigned int lineLength = 0;
+    unsigned int wrapCopyLength = 0;
+    uint32_t numPreparedLines = 0;
+};
+
+enum class rampShape { kLinear, kExponential };
+
+/** per-sample values of a ParameterRamp for one block; values is nullptr while the ramp is steady */
+template <typename SampleType>
+struct RampSpan
+{
+    const SampleType* values = nullptr;    ///< per-sample values, or nullptr if steady
+    SampleType steadyValue = 0.0f;        ///< the value of every sample while steady
+
+    bool isSteady() const { return values == nullptr; }
+    SampleType operator[](uint32_t i) const { return values != nullptr ? values[i] : steadyValue; }
+};
+
+/** block-rate parameter smoother: every call to process( ) is one linear segment, so a moving
+    parameter costs one add per sample and a steady one costs nothing.
+    kLinear reaches the target in rampTimeSeconds;
+    kExponential approaches it like a one-pole with rampTimeSeconds as the time constant,
+    evaluated at the segment ends only, and snaps once closer than the settle threshold.
+    SampleType is the type of the values handed to the processing kernels */
+template <typename SampleType>
+class ParameterRamp
+{
+public:
+    static constexpr uint32_t kMaxBlockSize = 256; ///< longest segment process( ) can produce
+
+    ParameterRamp() {}        /* C-TOR */
+    ~ParameterRamp() {}        /* D-TOR */
+
+    /** set the ramp time and shape; do this prior to any processing */
+    void reset(double _sampleRate, double rampTimeSeconds, rampShape _shape, SampleType _settleThreshold = 1.0e-6f)
+    {
+        shape = _shape;
+        settleThreshold = _settleThreshold;
+        rampLengthInSamples = juce::jmax(1u, (uint32_t)(_sampleRate * rampTimeSeconds));
+        decayPerSample = exp(-1.0 / rampLengthInSamples);
+        cachedDecayLength = 0;
+
+        setCurrentAndTargetValue(targetValue);
+    }
+
+    /** jump straight to a value, e.g. when (re)starting */
+    void setCurrentAndTargetValue(SampleType value)
+    {
+        currentValue = targetValue = value;
+        samplesRemaining = 0;
+    }
+
+    /** start a new ramp towards value */
+    void setTargetValue(SampleType value)
+    {
+        if (value == targetValue)
+            return;
+
+        targetValue = value;
+        samplesRemaining = rampLengthInSamples;
+    }
+
+    SampleType getCurrentValue() const { return currentValue; }
+    SampleType getTargetValue() const { return targetValue; }
+    bool isRamping() const { return currentValue != targetValue; }
+
+    /** advance by numSamples (at most kMaxBlockSize) and return the values for those samples */
+    RampSpan<SampleType> process(uint32_t numSamples)
+    {
+        RampSpan<SampleType> span;
+
+        if (!isRamping() || numSamples == 0)
+        {
+            span.steadyValue = currentValue;
+            return span;
+        }
+
+        jassert(numSamples <= kMaxBlockSize);
+        numSamples = juce::jmin(numSamples, kMaxBlockSize);
+
+        // --- value at the end of this segment
+        SampleType endValue = targetValue;
+        uint32_t segmentLength = numSamples;
+
+        if (shape == rampShape::kLinear)
+        {
+            segmentLength = juce::jmin(numSamples, samplesRemaining);
+            samplesRemaining -= segmentLength;
+
+            if (samplesRemaining > 0)
+                endValue = currentValue + (targetValue - currentValue) * segmentLength / (SampleType)(samplesRemaining + segmentLength);
+        }
+        else
+        {
+            if (numSamples != cachedDecayLength)
+            {
+                cachedDecay = (SampleType)pow(decayPerSample, numSamples);
+                cachedDecayLength = numSamples;
+            }
+
+            endValue = targetValue + (currentValue - targetValue) * cachedDecay;
+
+            if (fabs(endValue - targetValue) < settleThreshold)
+                endValue = targetValue;
+        }
+
+        const SampleType increment = (endValue - currentValue) / segmentLength;
+
+        for (uint32_t i = 0; i < segmentLength; ++i)
+            values[i] = currentValue + increment * (i + 1);
+
+        for (uint32_t i = segmentLength; i < numSamples; ++i)
+            values[i] = endValue;
+
+        values[segmentLength - 1] = endValue;
+        currentValue = endValue;
+
+        span.values = values;
+        span.steadyValue = endValue;
+        return span;
+    }
+
+private:
+    rampShape shape = rampShape::kLinear;
+    SampleType currentValue = 0.0f;
+    SampleType targetValue = 0.0f;
+    SampleType settleThreshold = 1.0e-6f;    ///< kExponential only
+    uint32_t rampLengthInSamples = 1;    ///< ramp time (kLinear) or time constant (kExponential)
+    uint32_t samplesRemaining = 0;        ///< kLinear only
+    double decayPerSample = 0.0;        ///< kExponential only
+    SampleType cachedDecay = 0.0f;            ///< decayPerSample ^ cachedDecayLength
+    uint32_t cachedDecayLength = 0;
+
+    SampleType values[kMaxBlockSize];
+};
+
+/** tone stage for a feedback path: a 2-pole TPT state variable low-pass (damping) followed by a
+    TPT one-pole high-pass (low cut), for up to two channels with independent state. Either stage
+    switches itself off at the edge of its range, so a neutral setting costs nothing */
+template <typename SampleType>
+class AlphaFeedbackTone
+{
+public:
+    static constexpr double kDampingOffHz = 20000.0;    ///< damping at or above this (or near Nyquist) is off
+    static constexpr double kLowCutOffHz = 20.0;        ///< low cut at or below this is off
+
+    AlphaFeedbackTone() {}        /* C-TOR */
+    ~AlphaFeedbackTone() {}        /* D-TOR */
+
+    /** clear the filter state and recalculate for a new sample rate */
+    void reset(double _sampleRate)
+    {
+        sampleRate = _sampleRate;
+        memset(lowPassState, 0, sizeof(lowPassState));
+        memset(highPassState, 0, sizeof(highPassState));
+        setCutoffs(dampingHz, lowCutHz);
+    }
+
+    /** set both cutoffs in Hz; the state is kept so this is safe between blocks */
+    void setCutoffs(double _dampingHz, double _lowCutHz)
+    {
+        dampingHz = _dampingHz;
+        lowCutHz = _lowCutHz;
+
+        if (sampleRate <= 0.0)
+            return;
+
+        lowPassActive = dampingHz < kDampingOffHz && dampingHz < 0.45 * sampleRate;
+        highPassActive = lowCutHz > kLowCutOffHz;
+
+        // --- Butterworth SVF, see Zavalishin, "The Art of VA Filter Design"
+        const double g = tan(kPi * juce::jmin(dampingHz, 0.45 * sampleRate) / sampleRate);
+        const double k = sqrt(2.0);
+        a1 = (SampleType)(1.0 / (1.0 + g * (g + k)));
+        a2 = (SampleType)(g * a1);
+        a3 = (SampleType)(g * a2);
+
+        const double gHighPass = tan(kPi * juce::jmin(lowCutHz, 0.45 * sampleRate) / sampleRate);
+        highPassG = (SampleType)(gHighPass / (1.0 + gHighPass));
+    }
+
+    /** true if any stage is doing something */
+    bool isActive() const { return lowPassActive || highPassActive; }
+
+    /** filter one sample of one channel */
+    SampleType processSample(uint32_t channel, SampleType x)
+    {
+        if (lowPassActive)
+            x = processLowPass(lowPassState[channel], x);
+
+        if (highPassActive)
+            x = processHighPass(highPassState[channel], x);
+
+        return x;
+    }
+
+    /** filter a span of up to two channels in place; a stereo pair runs as two lanes of one register */
+    void processBlock(SampleType* const* channels, uint32_t numChannels, uint32_t numSamples)
+    {
+        if constexpr (AlphaVector<SampleType>::size >= 2)
+        {
+            if (numChannels == 2)
+            {
+                if (lowPassActive && highPassActive)
+                    processStereo<true, true>(channels[0], channels[1], numSamples);
+                else if (lowPassActive)
+                    processStereo<true, false>(channels[0], channels[1], numSamples);
+                else if (highPassActive)
+                    processStereo<false, true>(channels[0], channels[1], numSamples);
+
+                return;
+            }
+        }
+
+        if (lowPassActive)
+        {
+            for (uint32_t i = 0; i < numSamples; ++i)
+                for (uint32_t channel = 0; channel < numChannels; ++channel)
+                    channels[channel][i] = processLowPass(lowPassState[channel], channels[channel][i]);
+        }
+
+        if (highPassActive)
+        {
+            for (uint32_t i = 0; i < numSamples; ++i)
+                for (uint32_t channel = 0; channel < numChannels; ++channel)
+                    channels[channel][i] = processHighPass(highPassState[channel], channels[channel][i]);
+        }
+    }
+
+private:
+    double sampleRate = 0.0;
+    double dampingHz = kDampingOffHz;
+    double lowCutHz = kLowCutOffHz;
+    bool lowPassActive = false;
+    bool highPassActive = false;
+
+    SampleType a1 = 0, a2 = 0, a3 = 0;    ///< SVF coefficients
+    SampleType highPassG = 0;            ///< one-pole coefficient G = g / (1 + g)
+
+    SampleType lowPassState[2][2] = {};    ///< [channel] { ic1eq, ic2eq }
+    SampleType highPassState[2] = {};    ///< [channel] integrator state
+
+    SampleType processLowPass(SampleType* state, SampleType v0) const
+    {
+        const SampleType v3 = v0 - state[1];
+        const SampleType v1 = a1 * state[0] + a2 * v3;
+        const SampleType v2 = state[1] + a2 * state[0] + a3 * v3;
+        state[0] = 2 * v1 - state[0];
+        state[1] = 2 * v2 - state[1];
+        return v2;
+    }
+
+    SampleType processHighPass(SampleType& state, SampleType x) const
+    {
+        const SampleType v = (x - state) * highPassG;
+        const SampleType lowPass = v + state;
+        state = lowPass + v;
+        return x - lowPass;
+    }
+
+    /** processLowPass( ) and processHighPass( ) with left in lane 0 and right in lane 1; the other
+        lanes stay zero. The state lives in registers for the whole span */
+    template <bool lowPass, bool highPass>
+    void processStereo(SampleType* left, SampleType* right, uint32_t numSamples)
+    {
+        using Vector = AlphaVector<SampleType>;
+        using Register = typename Vector::Register;
+
+        SampleType lanes[Vector::size] = {};
+
+        auto loadPair = [&lanes] (SampleType l, SampleType r)
+        {
+            lanes[0] = l;
+            lanes[1] = r;
+            return Vector::load(lanes);
+        };
+
+        Register ic1eq = loadPair(lowPassState[0][0], lowPassState[1][0]);
+        Register ic2eq = loadPair(lowPassState[0][1], lowPassState[1][1]);
+        Register highPassIntegrator = loadPair(highPassState[0], highPassState[1]);
+
+        const Register two = Vector::broadcast(2);
+        const Register va1 = Vector::broadcast(a1);
+        const Register va2 = Vector::broadcast(a2);
+        const Register va3 = Vector::broadcast(a3);
+        const Register vHighPassG = Vector::broadcast(highPassG);
+
+        for (uint32_t i = 0; i < numSamples; ++i)
+        {
+            Register x = loadPair(left[i], right[i]);
+
+            if constexpr (lowPass)
+            {
+                const Register v3 = Vector::sub(x, ic2eq);
+                const Register v1 = Vector::add(Vector::mul(va1, ic1eq), Vector::mul(va2, v3));
+                const Register v2 = Vector::add(Vector::add(ic2eq, Vector::mul(va2, ic1eq)), Vector::mul(va3, v3));
+                ic1eq = Vector::sub(Vector::mul(two, v1), ic1eq);
+                ic2eq = Vector::sub(Vector::mul(two, v2), ic2eq);
+                x = v2;
+            }
+
+            if constexpr (highPass)
+            {
+                const Register v = Vector::mul(Vector::sub(x, highPassIntegrator), vHighPassG);
+                const Register lowPassed = Vector::add(v, highPassIntegrator);
+                highPassIntegrator = Vector::add(lowPassed, v);
+                x = Vector::sub(x, lowPassed);
+            }
+
+            Vector::store(lanes, x);
+            left[i] = lanes[0];
+            right[i] = lanes[1];
+        }
+
+        // --- back to the per-channel state processSample( ) uses
+        Vector::store(lanes, ic1eq);
+        lowPassState[0][0] = lanes[0];
+        lowPassState[1][0] = lanes[1];
+        Vector::store(lanes, ic2eq);
+        lowPassState[0][1] = lanes[0];
+        lowPassState[1][1] = lanes[1];
+        Vector::store(lanes, highPassIntegrator);
+        highPassState[0] = lanes[0];
+        highPassState[1] = lanes[1];
+    }
+};
+
+struct AlphaSimpleDelayParameters
+{
+    AlphaSimpleDelayParameters& operator= (const AlphaSimpleDelayParameters& parameters)
+    {
+        if (this != &parameters)
+        {
+            wetDryMix = parameters.wetDryMix;
+            feedback = parameters.feedback;
+            delay = parameters.delay;
+            damping = parameters.damping;
+            lowCut = parameters.lowCut;
+        }
+
+        return *this;
+    }
+
+    double wetDryMix = 0.5;
+    double feedback = 0.0;
+    double delay = 0.5; // in seconds
+    double damping = AlphaFeedbackTone<double>::kDampingOffHz; // feedback low-pass in Hz; 20 kHz and up = off
+    double lowCut = AlphaFeedbackTone<double>::kLowCutOffHz; // feedback high-pass in Hz; 20 Hz and down = off
+};
+
+class IAudioSignalProcessor
+{
+public:
+    // --- pure virtual, derived classes must implement or will not compile
+    //     also means this is a pure abstract base class and is incomplete,
+    //     so it can only be used as a base class
+    //
+    /** initialize the object with the new sample rate */
+    virtual bool reset(double _sampleRate) = 0;
+
+    /** process one sample in and out */
+    virtual double processAudioSample(double xn) = 0;
+
+    /** return true if the derived object can process a frame, false otherwise */
+    virtual bool canProcessAudioFrame() = 0;
+
+    /** set or change the sample rate; normally this is done during reset( ) but may be needed outside of initialzation */
+    virtual void setSampleRate(double _sampleRate) {}
+
+    /** switch to enable/disable the aux input */
+    virtual void enableAuxInput(bool enableAuxInput) {}
+
+    /** for processing objects with a sidechain input or other necessary aux input
+            the return value is optional and will depend on the subclassed object */
+    virtual double processAuxInputAudioSample(double xn)
     {
         // --- do nothing
         return xn;
     }
 
+    /** process a block of planar (non-interleaved) channel data: inputChannels[channel][sample]
+        in-place processing is allowed, i.e. inputChannels[n] may equal outputChannels[n]
+        --- default implementation falls back to processAudioFrame( ) one frame at a time */
+    virtual bool processAudioBlock(const float* const* inputChannels,
+                                   float* const* outputChannels,
+                                   uint32_t numChannels,
+                                   uint32_t numSamples)
+    {
+        if (numChannels == 0 || numChannels > kMaxBlockChannels)
+            return false;
+
+        float inputFrame[kMaxBlockChannels];
+        float outputFrame[kMaxBlockChannels];
+
+        for (uint32_t i = 0; i < numSamples; ++i)
+        {
+            for (uint32_t channel = 0; channel < numChannels; ++channel)
+                inputFrame[channel] = inputChannels[channel][i];
+
+            if (!processAudioFrame(inputFrame, outputFrame, numChannels, numChannels))
+                return false;
+
+            for (uint32_t channel = 0; channel < numChannels; ++channel)
+                outputChannels[channel][i] = outputFrame[channel];
+        }
+
+        return true;
+    }
+
+    /** double precision version of processAudioBlock( ) for objects that can run natively in double
+        --- optional processing function */
+    virtual bool processAudioBlock(const double* const* inputChannels,
+                                   double* const* outputChannels,
+                                   uint32_t numChannels,
+                                   uint32_t numSamples)
+    {
+        // --- do nothing
+        return false; // NOT handled
+    }
+
     /** for processing objects with a sidechain input or other necessary aux input
     --- optional processing function
         e.g. does not make sense for some objects to implement this such as inherently mono objects like Biquad
@@ -388,22 +1564,955 @@ public:
         // --- do nothing
         return false; // NOT handled
     }
+
+protected:
+    static constexpr uint32_t kMaxBlockChannels = 8; ///< largest frame the default processAudioBlock( ) can build
 };
 
-class AlphaSimpleDelay : public IAudioSignalProcessor
-{
-public:
-    AlphaSimpleDelay() {}
-    ~AlphaSimpleDelay() {}
+template <typename SampleType>
+class AlphaSimpleDelay : public IAudioSignalProcessor
+{
+public:
+    // --- the overload for the other precision stays visible (and unhandled)
+    using IAudioSignalProcessor::processAudioBlock;
+
+    AlphaSimpleDelay() {}
+    ~AlphaSimpleDelay() {}
+
+    virtual bool reset(double _sampleRate) override
+    {
+        sampleRate = _sampleRate;
+        delayInSamples = sampleRate * parameters.delay;
+        delayBufferSize = (sampleRate * kMaximumDelaySeconds) + 1;
+
+        // --- both lines come from the arena; only the first reset( ) allocates. The copy after each
+        //     line covers the history window of a vector chunk, so it never wraps
+        delayMemory.prepare(2, kMaximumDelaySeconds, sampleRate, 1, kVectorChunkSize + 1);
+        leftDelayBuffer.attachToMemory(delayMemory.getLine(0), delayMemory.getLineLength(), delayMemory.getWrapCopyLength());
+        rightDelayBuffer.attachToMemory(delayMemory.getLine(1), delayMemory.getLineLength(), delayMemory.getWrapCopyLength());
+
+        leftChannelFeedback = 0.0;
+        rightChannelFeedback = 0.0;
+
+        idle = false;
+        silentSamples = 0;
+
+        feedbackTone.setCutoffs(parameters.damping, parameters.lowCut);
+        feedbackTone.reset(sampleRate);
+
+        // --- delay time glides like a one-pole, gains ramp linearly; start settled on the current parameters
+        delayRamp.reset(sampleRate, kDelayGlideSeconds, rampShape::kExponential, kDelaySettleThreshold);
+        feedbackRamp.reset(sampleRate, kGainRampSeconds, rampShape::kLinear);
+        wetDryMixRamp.reset(sampleRate, kGainRampSeconds, rampShape::kLinear);
+
+        delayRamp.setCurrentAndTargetValue((SampleType)delayInSamples);
+        feedbackRamp.setCurrentAndTargetValue((SampleType)parameters.feedback);
+        wetDryMixRamp.setCurrentAndTargetValue((SampleType)parameters.wetDryMix);
+
+        // --- expect stereo; processAudioBlock( ) re-selects if the channel count differs
+        selectKernels(2);
+
+        return true;
+    }
+
+    virtual bool canProcessAudioFrame() override
+    {
+        return true;
+    }
+
+    virtual double processAudioSample(double xn) override
+    {
+        SampleType sample = (SampleType)xn;
+        SampleType* channel = &sample;
+
+        processAudioBlock(&channel, &channel, 1, 1);
+
+        return sample;
+    }
+
+    virtual bool processAudioFrame(const float* inputFrame,
+                                   float* outputFrame,
+                                   uint32_t inputChannels,
+                                   uint32_t outputChannels) override
+    {
+        if (inputChannels == 0 || outputChannels == 0)
+        {
+            return false;
+        }
+
+        // Mono - use processAudioSample
+        if (outputChannels == 1)
+        {
+            outputFrame[0] = processAudioSample(inputFrame[0]);
+            outputFrame[1] = outputFrame[0];
+            return true;
+        }
+
+        // Stereo processing - a block of one frame, in the processing precision
+        SampleType frame[2] = { (SampleType)inputFrame[0], (SampleType)inputFrame[1] };
+        SampleType* channels[2] = { &frame[0], &frame[1] };
+
+        if (!processAudioBlock(channels, channels, 2, 1))
+            return false;
+
+        outputFrame[0] = (float)frame[0];
+        outputFrame[1] = (float)frame[1];
+
+        return true;
+    }
+
+    virtual bool processAudioBlock(const SampleType* const* inputChannels,
+                                   SampleType* const* outputChannels,
+                                   uint32_t numChannels,
+                                   uint32_t numSamples) override
+    {
+        if (numChannels == 0)
+        {
+            return false;
+        }
+
+        // Mono uses the left delay line only, stereo both
+        const uint32_t channelsToProcess = juce::jmin(numChannels, 2u);
+
+        // --- normally a no-op: the kernels were chosen on reset( ) for the expected layout
+        if (channelsToProcess != kernelChannels)
+            selectKernels(channelsToProcess);
+
+        // --- nothing audible left in the delay lines: stay on the dry-only path until the input wakes up
+        if (idle)
+        {
+            if (getPeak(inputChannels, channelsToProcess, numSamples) < kSilenceThreshold)
+            {
+                processIdle(inputChannels, outputChannels, channelsToProcess, numSamples);
+                return true;
+            }
+
+            idle = false;
+            silentSamples = 0;
+        }
+
+        for (uint32_t chunkStart = 0; chunkStart < numSamples; chunkStart += kVectorChunkSize)
+        {
+            const uint32_t chunkSize = juce::jmin(kVectorChunkSize, numSamples - chunkStart);
+            const SampleType* chunkInputs[2] = { nullptr, nullptr };
+            SampleType* chunkOutputs[2] = { nullptr, nullptr };
+
+            for (uint32_t channel = 0; channel < channelsToProcess; ++channel)
+            {
+                chunkInputs[channel] = inputChannels[channel] + chunkStart;
+                chunkOutputs[channel] = outputChannels[channel] + chunkStart;
+            }
+
+            // --- parameters advance once per chunk; steady ones cost nothing
+            const RampSpan<SampleType> delayValues = delayRamp.process(chunkSize);
+            const RampSpan<SampleType> feedbackValues = feedbackRamp.process(chunkSize);
+            const RampSpan<SampleType> wetDryMixValues = wetDryMixRamp.process(chunkSize);
+
+            // --- once the delay has settled and is at least one chunk long, every sample
+            //     the chunk reads was written before it started, so it can be vectorised
+            if (delayValues.isSteady() && (uint32_t)delayValues.steadyValue >= chunkSize)
+                (this->*vectorKernel)(chunkInputs, chunkOutputs, chunkSize, delayValues.steadyValue, feedbackValues, wetDryMixValues);
+            else
+                (this->*scalarKernel)(chunkInputs, chunkOutputs, chunkSize, delayValues, feedbackValues, wetDryMixValues);
+        }
+
+        updateIdleState(channelsToProcess, numSamples);
+
+        return true;
+    }
+
+    /** true while the delay lines hold nothing audible and the input is silent; processing is then a
+        dry-only pass-through */
+    bool isIdle() const { return idle; }
+
+    /** silence the lines, the feedback and the tone state, keeping the sample rate and parameters;
+        never allocates, so an engine can be reused from the audio thread */
+    void flush()
+    {
+        leftDelayBuffer.flushBuffer();
+        rightDelayBuffer.flushBuffer();
+
+        leftChannelFeedback = 0.0;
+        rightChannelFeedback = 0.0;
+
+        feedbackTone.reset(sampleRate);
+
+        idle = true;
+        silentSamples = 0;
+    }
+
+    /** time for the repeats of an impulse to fall below the silence threshold, from the current
+        parameters; infinite when the feedback does not decay */
+    double getTailLengthSeconds() const
+    {
+        const double feedback = fabs(parameters.feedback);
+
+        if (feedback >= 1.0)
+            return std::numeric_limits<double>::infinity();
+
+        // --- the first repeat arrives after one delay, each further one is feedback times quieter
+        const double repeats = feedback > 0.0 ? log(kSilenceThreshold) / log(feedback) : 0.0;
+
+        return parameters.delay * (1.0 + repeats);
+    }
+
+    AlphaSimpleDelayParameters getParameters()
+    {
+        return parameters;
+    }
+
+    /** rampToTarget = false jumps straight to the new values, e.g. for an engine that is silent */
+    void setParameters(AlphaSimpleDelayParameters _parameters, bool rampToTarget = true)
+    {
+        parameters = _parameters;
+
+        feedbackTone.setCutoffs(parameters.damping, parameters.lowCut);
+
+        if (!rampToTarget)
+        {
+            delayRamp.setCurrentAndTargetValue((SampleType)(sampleRate * parameters.delay));
+            feedbackRamp.setCurrentAndTargetValue((SampleType)parameters.feedback);
+            wetDryMixRamp.setCurrentAndTargetValue((SampleType)parameters.wetDryMix);
+            return;
+        }
+
+        // --- the ramps take it from here, one segment per processed chunk
+        delayRamp.setTargetValue((SampleType)(sampleRate * parameters.delay));
+        feedbackRamp.setTargetValue((SampleType)parameters.feedback);
+        wetDryMixRamp.setTargetValue((SampleType)parameters.wetDryMix);
+    }
+
+private:
+    static constexpr uint32_t kVectorChunkSize = 128;    ///< largest run handled by one pass; at most ParameterRamp<SampleType>::kMaxBlockSize
+    static constexpr SampleType kDelaySettleThreshold = 1e-3f; ///< in samples; closer than this snaps to the target delay
+    static constexpr double kMaximumDelaySeconds = 2.0;    ///< delay line length
+    static constexpr double kDelayGlideSeconds = 0.045;    ///< delay time glide, time constant
+    static constexpr double kGainRampSeconds = 0.020;    ///< feedback and mix ramp time
+    static constexpr SampleType kSilenceThreshold = (SampleType)1.0e-5; ///< -100 dBFS; quieter counts as silence
+
+    /** peak magnitude over numSamples of the given channels */
+    static SampleType getPeak(const SampleType* const* channels, uint32_t numChannels, uint32_t numSamples)
+    {
+        SampleType peak = 0;
+
+        for (uint32_t channel = 0; channel < numChannels; ++channel)
+        {
+            const auto range = juce::FloatVectorOperations::findMinAndMax(channels[channel], (int)numSamples);
+            peak = juce::jmax(peak, -range.getStart(), range.getEnd());
+        }
+
+        return peak;
+    }
+
+    /** go idle once everything written to the lines has been silent for longer than the longest delay
+        in use, i.e. the lines can no longer produce anything audible. The lines are cleared on the
+        way, as the write position stands still while idle: a longer delay after resuming would
+        otherwise reach back past the silence to what was written before it */
+    void updateIdleState(uint32_t numChannels, uint32_t numSamples)
+    {
+        CircularBuffer<SampleType>* delayBuffers[2] = { &leftDelayBuffer, &rightDelayBuffer };
+        SampleType peak = 0;
+
+        for (uint32_t channel = 0; channel < numChannels; ++channel)
+            peak = juce::jmax(peak, delayBuffers[channel]->getRecentPeak(numSamples));
+
+        silentSamples = peak < kSilenceThreshold ? silentSamples + numSamples : 0;
+
+        const SampleType longestDelay = juce::jmax(delayRamp.getCurrentValue(), delayRamp.getTargetValue());
+
+        if (silentSamples > (uint32_t)longestDelay + 1)
+            flush();
+    }
+
+    /** idle pass-through: the wet signal is silent, so only the dry part of the input is left; the
+        ramps keep moving so that parameters are current when processing resumes */
+    void processIdle(const SampleType* const* inputChannels, SampleType* const* outputChannels, uint32_t numChannels, uint32_t numSamples)
+    {
+        for (uint32_t chunkStart = 0; chunkStart < numSamples; chunkStart += kVectorChunkSize)
+        {
+            const uint32_t chunkSize = juce::jmin(kVectorChunkSize, numSamples - chunkStart);
+
+            delayRamp.process(chunkSize);
+            feedbackRamp.process(chunkSize);
+            const RampSpan<SampleType> wetDryMixValues = wetDryMixRamp.process(chunkSize);
+
+            for (uint32_t channel = 0; channel < numChannels; ++channel)
+            {
+                const SampleType* input = inputChannels[channel] + chunkStart;
+                SampleType* output = outputChannels[channel] + chunkStart;
+
+                if (wetDryMixValues.isSteady())
+                {
+                    juce::FloatVectorOperations::multiply(output, input, 1 - wetDryMixValues.steadyValue, (int)chunkSize);
+                    continue;
+                }
+
+                for (uint32_t i = 0; i < chunkSize; ++i)
+                    output[i] = input[i] * (1 - wetDryMixValues[i]);
+            }
+        }
+    }
+
+    using ScalarKernel = void (AlphaSimpleDelay::*)(const SampleType* const*, SampleType* const*, uint32_t,
+                                                    const RampSpan<SampleType>&, const RampSpan<SampleType>&, const RampSpan<SampleType>&);
+    using VectorKernel = void (AlphaSimpleDelay::*)(const SampleType* const*, SampleType* const*, uint32_t,
+                                                    SampleType, const RampSpan<SampleType>&, const RampSpan<SampleType>&);
+
+    /** point the chunk kernels at the specialisations for numChannels (1 or 2) */
+    void selectKernels(uint32_t numChannels)
+    {
+        kernelChannels = numChannels;
+
+        if (numChannels == 1)
+        {
+            scalarKernel = &AlphaSimpleDelay::processChunk<1>;
+            vectorKernel = &AlphaSimpleDelay::processChunkVectorized<1>;
+        }
+        else
+        {
+            scalarKernel = &AlphaSimpleDelay::processChunk<2>;
+            vectorKernel = &AlphaSimpleDelay::processChunkVectorized<2>;
+        }
+    }
+
+    /** scalar loop; handles delays shorter than the chunk and a moving delay time */
+    template <uint32_t numChannels>
+    void processChunk(const SampleType* const* inputs, SampleType* const* outputs, uint32_t numSamples,
+                      const RampSpan<SampleType>& delayValues, const RampSpan<SampleType>& feedbackValues, const RampSpan<SampleType>& wetDryMixValues)
+    {
+        CircularBuffer<SampleType>* delayBuffers[2] = { &leftDelayBuffer, &rightDelayBuffer };
+        SampleType* channelFeedback[2] = { &leftChannelFeedback, &rightChannelFeedback };
+        const bool toneActive = feedbackTone.isActive();
+
+        for (uint32_t i = 0; i < numSamples; ++i)
+        {
+            delayInSamples = delayValues[i];
+
+            const SampleType feedback = feedbackValues[i];
+            const SampleType wet = wetDryMixValues[i];
+            const SampleType dry = 1 - wet;
+
+            for (uint32_t channel = 0; channel < numChannels; ++channel)
+            {
+                // --- read the input before writing, processing may be in-place
+                const SampleType inputSample = inputs[channel][i];
+
+                delayBuffers[channel]->writeBuffer(inputSample + *channelFeedback[channel]);
+
+                SampleType delayedSample = delayBuffers[channel]->template readBufferAs<interpolationType::kLinear>(delayInSamples);
+
+                *channelFeedback[channel] = feedback * delayedSample;
+
+                if (toneActive)
+                    *channelFeedback[channel] = feedbackTone.processSample(channel, *channelFeedback[channel]);
+
+                outputs[channel][i] = inputSample * dry + (delayedSample * wet);
+            }
+        }
+    }
+
+    /** vectorised kernel; requires a settled delay of at least numSamples samples
+        so that the whole read window precedes the write window */
+    template <uint32_t numChannels>
+    void processChunkVectorized(const SampleType* const* inputs, SampleType* const* outputs, uint32_t numSamples,
+                                SampleType settledDelayInSamples, const RampSpan<SampleType>& feedbackValues, const RampSpan<SampleType>& wetDryMixValues)
+    {
+        using Vector = AlphaVector<SampleType>;
+
+        delayInSamples = settledDelayInSamples;
+        const int readDelay = (int)delayInSamples;
+        const SampleType fraction = delayInSamples - (SampleType)readDelay;
+
+        CircularBuffer<SampleType>* delayBuffers[2] = { &leftDelayBuffer, &rightDelayBuffer };
+        SampleType* channelFeedback[2] = { &leftChannelFeedback, &rightChannelFeedback };
+
+        // --- history[k] is the sample written (readDelay + 1 - k) samples before the chunk;
+        //     output i interpolates between history[i + 1] and the one-older history[i].
+        //     It points straight into the delay line unless the window wraps past the copy at its end.
+        SampleType historyCopy[2][kVectorChunkSize + 1];
+        const SampleType* history[2];
+        SampleType delayed[2][kVectorChunkSize];
+        SampleType feedbackIn[2][kVectorChunkSize + 1];
+        SampleType toWrite[kVectorChunkSize];
+
+        for (uint32_t channel = 0; channel < numChannels; ++channel)
+        {
+            history[channel] = delayBuffers[channel]->getReadPointer(readDelay + 1, numSamples + 1);
+
+            if (history[channel] == nullptr)
+            {
+                delayBuffers[channel]->readBlock(readDelay + 1, historyCopy[channel], numSamples + 1);
+                history[channel] = historyCopy[channel];
+            }
+
+            feedbackIn[channel][0] = *channelFeedback[channel];
+        }
+
+        const uint32_t vectorEnd = numSamples - (numSamples % Vector::size);
+        const auto fractionVector = Vector::broadcast(fraction);
+        const auto oneVector = Vector::broadcast(1.0f);
+        const auto steadyFeedback = Vector::broadcast(feedbackValues.steadyValue);
+        const auto steadyWet = Vector::broadcast(wetDryMixValues.steadyValue);
+
+        // --- ramping gains are loaded per vector, steady ones stay in a register
+        auto gainAt = [] (const RampSpan<SampleType>& span, typename Vector::Register steady, uint32_t i)
+        {
+            return span.isSteady() ? steady : Vector::load(span.values + i);
+        };
+
+        // --- fractional read and feedback amount, all channels in the same pass
+        for (uint32_t i = 0; i < vectorEnd; i += Vector::size)
+        {
+            const auto feedbackVector = gainAt(feedbackValues, steadyFeedback, i);
+
+            for (uint32_t channel = 0; channel < numChannels; ++channel)
+            {
+                const auto newer = Vector::load(&history[channel][i + 1]);
+                const auto older = Vector::load(&history[channel][i]);
+                const auto y = Vector::add(newer, Vector::mul(fractionVector, Vector::sub(older, newer)));
+
+                Vector::store(&delayed[channel][i], y);
+                Vector::store(&feedbackIn[channel][i + 1], Vector::mul(feedbackVector, y));
+            }
+        }
+
+        for (uint32_t i = vectorEnd; i < numSamples; ++i)
+        {
+            for (uint32_t channel = 0; channel < numChannels; ++channel)
+            {
+                const SampleType newer = history[channel][i + 1];
+                const SampleType y = newer + fraction * (history[channel][i] - newer);
+
+                delayed[channel][i] = y;
+                feedbackIn[channel][i + 1] = feedbackValues[i] * y;
+            }
+        }
+
+        // --- the tone stage only depends on the read-out span, so it runs over the whole chunk at once
+        if (feedbackTone.isActive())
+        {
+            SampleType* feedbackSpans[2] = { &feedbackIn[0][1], &feedbackIn[1][1] };
+            feedbackTone.processBlock(feedbackSpans, numChannels, numSamples);
+        }
+
+        // --- write with the previous sample's feedback, then the wet/dry mix;
+        //     the input is consumed before the output is stored, so in-place is safe
+        for (uint32_t channel = 0; channel < numChannels; ++channel)
+        {
+            const SampleType* input = inputs[channel];
+            SampleType* output = outputs[channel];
+
+            for (uint32_t i = 0; i < vectorEnd; i += Vector::size)
+            {
+                const auto x = Vector::load(input + i);
+                const auto wet = gainAt(wetDryMixValues, steadyWet, i);
+                const auto dry = Vector::sub(oneVector, wet);
+
+                Vector::store(toWrite + i, Vector::add(x, Vector::load(&feedbackIn[channel][i])));
+                Vector::store(output + i, Vector::add(Vector::mul(x, dry), Vector::mul(Vector::load(&delayed[channel][i]), wet)));
+            }
+
+            for (uint32_t i = vectorEnd; i < numSamples; ++i)
+            {
+                const SampleType x = input[i];
+                const SampleType wet = wetDryMixValues[i];
+                toWrite[i] = x + feedbackIn[channel][i];
+                output[i] = x * (1 - wet) + delayed[channel][i] * wet;
+            }
+
+            delayBuffers[channel]->writeBlock(toWrite, numSamples);
+
+            *channelFeedback[channel] = feedbackIn[channel][numSamples];
+        }
+    }
+
+    AlphaSimpleDelayParameters parameters;
+    double sampleRate = 0;
+    SampleType delayInSamples = 0;
+    int delayBufferSize= 0;
+    float readHead = 0;
+    int writeHead = 0;
+
+    SampleType leftChannelFeedback = 0.0;
+    SampleType rightChannelFeedback = 0.0;
+
+    DelayMemoryArena<SampleType> delayMemory;    ///< backs both delay lines
+    CircularBuffer<SampleType> leftDelayBuffer;
+    CircularBuffer<SampleType> rightDelayBuffer;
+
+    AlphaFeedbackTone<SampleType> feedbackTone;    ///< damping / low cut in the feedback path
+
+    ParameterRamp<SampleType> delayRamp;        ///< in samples
+    ParameterRamp<SampleType> feedbackRamp;
+    ParameterRamp<SampleType> wetDryMixRamp;
+
+    bool idle = false;                ///< see isIdle( )
+    uint32_t silentSamples = 0;        ///< how long everything written to the lines has been silent
+
+    uint32_t kernelChannels = 0;    ///< channel count the kernels below are specialised for
+    ScalarKernel scalarKernel = &AlphaSimpleDelay::processChunk<2>;
+    VectorKernel vectorKernel = &AlphaSimpleDelay::processChunkVectorized<2>;
+};
+
+
+/** one tap of AlphaMultiTapDelay */
+struct AlphaDelayTap
+{
+    double delay = 0.25;    // in seconds
+    double gain = 1.0;        // level of the tap in the wet signal
+    double pan = 0.0;        // -1 = left only ... +1 = right only; stereo only
+    double feedback = 0.0;    // amount of the tap fed back into the delay line
+};
+
+struct AlphaMultiTapDelayParameters
+{
+    static constexpr uint32_t kMaxTaps = 8;
+
+    AlphaMultiTapDelayParameters& operator= (const AlphaMultiTapDelayParameters& parameters)
+    {
+        if (this != &parameters)
+        {
+            wetDryMix = parameters.wetDryMix;
+            numTaps = parameters.numTaps;
+
+            for (uint32_t i = 0; i < kMaxTaps; ++i)
+                taps[i] = parameters.taps[i];
+        }
+
+        return *this;
+    }
+
+    double wetDryMix = 0.5;
+    uint32_t numTaps = 1;    // taps[0 .. numTaps - 1] are used
+    AlphaDelayTap taps[kMaxTaps];
+};
+
+/** N taps read from one delay line per channel in a single pass; every tap adds its own gain and
+    pan to the wet signal and its own feedback to the line. A chunk is never longer than the
+    shortest tap, so every read in it precedes its writes and each settled tap is one vectorised
+    pass; a tap whose delay is gliding reads once per sample until it settles */
+template <typename SampleType>
+class AlphaMultiTapDelay : public IAudioSignalProcessor
+{
+public:
+    // --- the overload for the other precision stays visible (and unhandled)
+    using IAudioSignalProcessor::processAudioBlock;
+
+    AlphaMultiTapDelay() {}
+    ~AlphaMultiTapDelay() {}
+
+    virtual bool reset(double _sampleRate) override
+    {
+        sampleRate = _sampleRate;
+        delayBufferSize = (sampleRate * kMaximumDelaySeconds) + 1;
+
+        // --- both lines come from the arena; only the first reset( ) allocates. The copy after each
+        //     line covers a tap's history window for one chunk, so it never wraps
+        delayMemory.prepare(2, kMaximumDelaySeconds, sampleRate, 1, kChunkSize + 1);
+        leftDelayBuffer.attachToMemory(delayMemory.getLine(0), delayMemory.getLineLength(), delayMemory.getWrapCopyLength());
+        rightDelayBuffer.attachToMemory(delayMemory.getLine(1), delayMemory.getLineLength(), delayMemory.getWrapCopyLength());
+
+        wetDryMixRamp.reset(sampleRate, kGainRampSeconds, rampShape::kLinear);
+        wetDryMixRamp.setCurrentAndTargetValue((SampleType)parameters.wetDryMix);
+
+        // --- tap delays glide like AlphaSimpleDelay's, gains ramp linearly; start settled on the tap table
+        for (auto& tap : tapRamps)
+        {
+            tap.delay.reset(sampleRate, kDelayGlideSeconds, rampShape::kExponential, kDelaySettleThreshold);
+            tap.gain[0].reset(sampleRate, kGainRampSeconds, rampShape::kLinear);
+            tap.gain[1].reset(sampleRate, kGainRampSeconds, rampShape::kLinear);
+            tap.monoGain.reset(sampleRate, kGainRampSeconds, rampShape::kLinear);
+            tap.feedback.reset(sampleRate, kGainRampSeconds, rampShape::kLinear);
+        }
+
+        updateTaps(false);
+
+        return true;
+    }
+
+    virtual bool canProcessAudioFrame() override
+    {
+        return true;
+    }
+
+    virtual double processAudioSample(double xn) override
+    {
+        SampleType sample = (SampleType)xn;
+        SampleType* channel = &sample;
+
+        processAudioBlock(&channel, &channel, 1, 1);
+
+        return sample;
+    }
+
+    virtual bool processAudioFrame(const float* inputFrame,
+                                   float* outputFrame,
+                                   uint32_t inputChannels,
+                                   uint32_t outputChannels) override
+    {
+        if (inputChannels == 0 || outputChannels == 0)
+        {
+            return false;
+        }
+
+        // Mono - use processAudioSample
+        if (outputChannels == 1)
+        {
+            outputFrame[0] = processAudioSample(inputFrame[0]);
+            return true;
+        }
+
+        // Stereo processing - a block of one frame, in the processing precision
+        SampleType frame[2] = { (SampleType)inputFrame[0], (SampleType)inputFrame[1] };
+        SampleType* channels[2] = { &frame[0], &frame[1] };
+
+        if (!processAudioBlock(channels, channels, 2, 1))
+            return false;
+
+        outputFrame[0] = (float)frame[0];
+        outputFrame[1] = (float)frame[1];
+
+        return true;
+    }
+
+    virtual bool processAudioBlock(const SampleType* const* inputChannels,
+                                   SampleType* const* outputChannels,
+                                   uint32_t numChannels,
+                                   uint32_t numSamples) override
+    {
+        if (numChannels == 0)
+        {
+            return false;
+        }
+
+        // Mono uses the left delay line only, stereo both
+        const uint32_t channelsToProcess = juce::jmin(numChannels, 2u);
+        const uint32_t tapsToProcess = getNumSoundingTaps();
+
+        // --- the delays only move between their current and target values during the block,
+        //     so no chunk is longer than the shortest delay any tap passes through
+        uint32_t longestChunk = kChunkSize;
+
+        for (uint32_t t = 0; t < tapsToProcess; ++t)
+        {
+            const ParameterRamp<SampleType>& delay = tapRamps[t].delay;
+            longestChunk = juce::jmin(longestChunk, (uint32_t)juce::jmin(delay.getCurrentValue(), delay.getTargetValue()));
+        }
+
+        longestChunk = juce::jmax(1u, longestChunk);
+
+        for (uint32_t chunkStart = 0; chunkStart < numSamples; chunkStart += longestChunk)
+        {
+            const uint32_t chunkSize = juce::jmin(longestChunk, numSamples - chunkStart);
+            const RampSpan<SampleType> wetDryMixValues = wetDryMixRamp.process(chunkSize);
+
+            // --- every ramp advances once per chunk, for all channels; steady ones cost nothing
+            TapSpans tapValues[AlphaMultiTapDelayParameters::kMaxTaps];
+
+            for (uint32_t t = 0; t < tapsToProcess; ++t)
+            {
+                TapRamps& tap = tapRamps[t];
+                tapValues[t].delay = tap.delay.process(chunkSize);
+                tapValues[t].gain[0] = tap.gain[0].process(chunkSize);
+                tapValues[t].gain[1] = tap.gain[1].process(chunkSize);
+                tapValues[t].monoGain = tap.monoGain.process(chunkSize);
+                tapValues[t].feedback = tap.feedback.process(chunkSize);
+            }
+
+            for (uint32_t channel = 0; channel < channelsToProcess; ++channel)
+            {
+                processChunk(inputChannels[channel] + chunkStart, outputChannels[channel] + chunkStart,
+                             channel, channelsToProcess == 1, chunkSize, wetDryMixValues, tapValues, tapsToProcess);
+            }
+        }
+
+        return true;
+    }
+
+    AlphaMultiTapDelayParameters getParameters()
+    {
+        return parameters;
+    }
+
+    /** tap delays glide and tap gains, feedback and the wet/dry mix ramp from the next block on;
+        taps added or removed fade in or out */
+    void setParameters(AlphaMultiTapDelayParameters _parameters)
+    {
+        parameters = _parameters;
+        parameters.numTaps = juce::jmin(parameters.numTaps, AlphaMultiTapDelayParameters::kMaxTaps);
+
+        wetDryMixRamp.setTargetValue((SampleType)parameters.wetDryMix);
+
+        updateTaps(true);
+    }
+
+private:
+    static constexpr uint32_t kChunkSize = 128;            ///< longest run handled by one pass; at most ParameterRamp<SampleType>::kMaxBlockSize
+    static constexpr SampleType kDelaySettleThreshold = 1e-3f; ///< in samples; closer than this snaps to the target delay
+    static constexpr double kDelayGlideSeconds = 0.045;    ///< tap delay glide, time constant
+    static constexpr double kGainRampSeconds = 0.020;    ///< tap gain, feedback and mix ramp time
+    static constexpr double kMaximumDelaySeconds = 2.0;    ///< delay line length
+
+    /** a tap in the form the kernel uses; see updateTaps( ) */
+    struct TapRamps
+    {
+        ParameterRamp<SampleType> delay;        ///< in samples, at least 1
+        ParameterRamp<SampleType> gain[2];        ///< left, right; pan is folded in
+        ParameterRamp<SampleType> monoGain;        ///< mono ignores pan
+        ParameterRamp<SampleType> feedback;
+    };
+
+    /** one chunk's worth of a tap's ramps */
+    struct TapSpans
+    {
+        RampSpan<SampleType> delay;
+        RampSpan<SampleType> gain[2];
+        RampSpan<SampleType> monoGain;
+        RampSpan<SampleType> feedback;
+    };
+
+    /** true while the tap is audible or still feeds the line */
+    bool isTapSounding(uint32_t t) const
+    {
+        const TapRamps& tap = tapRamps[t];
+
+        return tap.gain[0].getCurrentValue() != 0 || tap.gain[1].getCurrentValue() != 0
+            || tap.monoGain.getCurrentValue() != 0 || tap.feedback.getCurrentValue() != 0;
+    }
+
+    /** taps in the table, plus removed ones that are still fading out */
+    uint32_t getNumSoundingTaps() const
+    {
+        uint32_t numSounding = parameters.numTaps;
+
+        for (uint32_t t = numSounding; t < AlphaMultiTapDelayParameters::kMaxTaps; ++t)
+            if (isTapSounding(t))
+                numSounding = t + 1;
+
+        return numSounding;
+    }
+
+    /** convert the tap table to samples and gains; pan is a balance control, unity at the centre.
+        Taps past numTaps head for silence. rampToTarget = false jumps straight to the new values */
+    void updateTaps(bool rampToTarget)
+    {
+        const int longestReadDelay = juce::jmax(1, delayBufferSize - (int)kChunkSize - 2);
+
+        auto setValue = [rampToTarget] (ParameterRamp<SampleType>& ramp, double value)
+        {
+            if (rampToTarget)
+                ramp.setTargetValue((SampleType)value);
+            else
+                ramp.setCurrentAndTargetValue((SampleType)value);
+        };
+
+        for (uint32_t t = 0; t < AlphaMultiTapDelayParameters::kMaxTaps; ++t)
+        {
+            const AlphaDelayTap& tap = parameters.taps[t];
+            const double level = t < parameters.numTaps ? tap.gain : 0.0;
+            const double pan = juce::jlimit(-1.0, 1.0, tap.pan);
+            const double delayInSamples = juce::jlimit(1.0, (double)longestReadDelay, sampleRate * tap.delay);
+
+            TapRamps& ramps = tapRamps[t];
+
+            // --- a tap coming in from silence starts out at its delay; only its level fades in
+            if (rampToTarget && isTapSounding(t))
+                ramps.delay.setTargetValue((SampleType)delayInSamples);
+            else
+                ramps.delay.setCurrentAndTargetValue((SampleType)delayInSamples);
+
+            setValue(ramps.gain[0], level * juce::jmin(1.0, 1.0 - pan));
+            setValue(ramps.gain[1], level * juce::jmin(1.0, 1.0 + pan));
+            setValue(ramps.monoGain, level);
+            setValue(ramps.feedback, t < parameters.numTaps ? tap.feedback : 0.0);
+        }
+    }
+
+    /** all taps of one channel for numSamples <= the shortest delay of any tap, then the write */
+    void processChunk(const SampleType* input, SampleType* output, uint32_t channel, bool isMono, uint32_t numSamples,
+                      const RampSpan<SampleType>& wetDryMixValues, const TapSpans* tapValues, uint32_t numTaps)
+    {
+        using Vector = AlphaVector<SampleType>;
+
+        CircularBuffer<SampleType>& delayBuffer = channel == 0 ? leftDelayBuffer : rightDelayBuffer;
+
+        SampleType wetSum[kChunkSize] = {};
+        SampleType feedbackSum[kChunkSize] = {};
+        SampleType historyCopy[kChunkSize + 1];
+        SampleType delayed[kChunkSize];
+        SampleType toWrite[kChunkSize];
+
+        const uint32_t vectorEnd = numSamples - (numSamples % Vector::size);
+
+        // --- ramping gains are loaded per vector, steady ones stay in a register
+        auto gainAt = [] (const RampSpan<SampleType>& span, typename Vector::Register steady, uint32_t i)
+        {
+            return span.isSteady() ? steady : Vector::load(span.values + i);
+        };
+
+        for (uint32_t t = 0; t < numTaps; ++t)
+        {
+            const TapSpans& tap = tapValues[t];
+            const RampSpan<SampleType>& gainValues = isMono ? tap.monoGain : tap.gain[channel];
+
+            // --- faded out (or never in): nothing to read
+            if (gainValues.isSteady() && gainValues.steadyValue == 0 && tap.feedback.isSteady() && tap.feedback.steadyValue == 0)
+                continue;
+
+            if (tap.delay.isSteady())
+            {
+                const int readDelay = (int)tap.delay.steadyValue;
+                const SampleType fraction = tap.delay.steadyValue - (SampleType)readDelay;
+
+                // --- history[k] was written (readDelay + 1 - k) samples before the chunk; output i
+                //     interpolates between history[i + 1] and the one-older history[i]
+                const SampleType* history = delayBuffer.getReadPointer(readDelay + 1, numSamples + 1);
+
+                if (history == nullptr)
+                {
+                    delayBuffer.readBlock(readDelay + 1, historyCopy, numSamples + 1);
+                    history = historyCopy;
+                }
+
+                const auto fractionVector = Vector::broadcast(fraction);
+
+                for (uint32_t i = 0; i < vectorEnd; i += Vector::size)
+                {
+                    const auto newer = Vector::load(&history[i + 1]);
+                    const auto older = Vector::load(&history[i]);
+                    Vector::store(delayed + i, Vector::add(newer, Vector::mul(fractionVector, Vector::sub(older, newer))));
+                }
+
+                for (uint32_t i = vectorEnd; i < numSamples; ++i)
+                {
+                    const SampleType newer = history[i + 1];
+                    delayed[i] = newer + fraction * (history[i] - newer);
+                }
+            }
+            else
+            {
+                // --- gliding: one fractional read per sample, every one of them before the chunk's writes
+                delayBuffer.template readBlockAs<interpolationType::kLinear>(tap.delay.values, delayed, numSamples);
+            }
+
+            const auto steadyGain = Vector::broadcast(gainValues.steadyValue);
+            const auto steadyFeedback = Vector::broadcast(tap.feedback.steadyValue);
+
+            for (uint32_t i = 0; i < vectorEnd; i += Vector::size)
+            {
+                const auto y = Vector::load(delayed + i);
+
+                Vector::store(wetSum + i, Vector::add(Vector::load(wetSum + i), Vector::mul(gainAt(gainValues, steadyGain, i), y)));
+                Vector::store(feedbackSum + i, Vector::add(Vector::load(feedbackSum + i), Vector::mul(gainAt(tap.feedback, steadyFeedback, i), y)));
+            }
+
+            for (uint32_t i = vectorEnd; i < numSamples; ++i)
+            {
+                wetSum[i] += gainValues[i] * delayed[i];
+                feedbackSum[i] += tap.feedback[i] * delayed[i];
+            }
+        }
+
+        // --- the input is consumed before the output is stored, so in-place is safe
+        for (uint32_t i = 0; i < numSamples; ++i)
+        {
+            const SampleType x = input[i];
+            const SampleType wet = wetDryMixValues[i];
+
+            toWrite[i] = x + feedbackSum[i];
+            output[i] = x * (1 - wet) + wetSum[i] * wet;
+        }
+
+        delayBuffer.writeBlock(toWrite, numSamples);
+    }
+
+    AlphaMultiTapDelayParameters parameters;
+    double sampleRate = 0;
+    int delayBufferSize = 0;
+
+    TapRamps tapRamps[AlphaMultiTapDelayParameters::kMaxTaps];
+
+    DelayMemoryArena<SampleType> delayMemory;    ///< backs both delay lines
+    CircularBuffer<SampleType> leftDelayBuffer;
+    CircularBuffer<SampleType> rightDelayBuffer;
+
+    ParameterRamp<SampleType> wetDryMixRamp;
+};
+
+
+enum class fdnMatrix { kHouseholder, kHadamard };
+
+struct AlphaFeedbackDelayNetworkParameters
+{
+    AlphaFeedbackDelayNetworkParameters& operator= (const AlphaFeedbackDelayNetworkParameters& parameters)
+    {
+        if (this != &parameters)
+        {
+            wetDryMix = parameters.wetDryMix;
+            feedback = parameters.feedback;
+            delay = parameters.delay;
+            spread = parameters.spread;
+            matrix = parameters.matrix;
+        }
+
+        return *this;
+    }
+
+    double wetDryMix = 0.5;
+    double feedback = 0.5;    // gain around the loop; below 1.0 to decay
+    double delay = 0.25;    // longest line, in seconds (at most 1 s)
+    double spread = 0.5;    // shortest line as a fraction of the longest; the others are spaced geometrically
+    fdnMatrix matrix = fdnMatrix::kHouseholder;
+};
+
+/** feedback delay network of numLines (4 or 8) lines mixed through an orthogonal matrix.
+    The lines are interleaved: one LineFrame per sample holds one sample from every line. Each
+    sample gathers one value per line into a frame register, and the matrix, the feedback gain
+    and the write are a few vector ops on it.
+    Left input feeds the even lines and the left output sums them; right uses the odd lines */
+template <typename SampleType, uint32_t numLines = 4>
+class AlphaFeedbackDelayNetwork : public IAudioSignalProcessor
+{
+    static_assert(numLines == 4 || numLines == 8, "AlphaFeedbackDelayNetwork has 4 or 8 lines");
+
+public:
+    // --- the overload for the other precision stays visible (and unhandled)
+    using IAudioSignalProcessor::processAudioBlock;
+
+    AlphaFeedbackDelayNetwork()
+    {
+        // --- the Hadamard matrix by columns, scale included, and the lanes each input feeds
+        for (uint32_t line = 0; line < numLines; ++line)
+        {
+            LineFrame column = {};
+            column.sample[line] = 1;
+            mixHadamard(column.sample);
+            hadamardColumns[line] = column;
+
+            leftInputLanes.sample[line] = (line & 1) == 0 ? 1 : 0;
+            rightInputLanes.sample[line] = (line & 1) == 0 ? 0 : 1;
+        }
+    }
+
+    ~AlphaFeedbackDelayNetwork() {}
 
     virtual bool reset(double _sampleRate) override
     {
         sampleRate = _sampleRate;
-        delayInSamples = sampleRate + parameters.delay;
-        delayBufferSize = (sampleRate * 2) + 1;
+        delayBufferSize = (int)(sampleRate * kMaximumDelaySeconds) + 1;
+
+        // --- the interleaved lines come from the arena; only the first reset( ) allocates
+        delayMemory.prepare(1, kMaximumDelaySeconds, sampleRate);
+        lines.attachToMemory(delayMemory.getLine(0), delayMemory.getLineLength());
+
+        feedbackRamp.reset(sampleRate, kGainRampSeconds, rampShape::kLinear);
+        wetDryMixRamp.reset(sampleRate, kGainRampSeconds, rampShape::kLinear);
+
+        feedbackRamp.setCurrentAndTargetValue((SampleType)parameters.feedback);
+        wetDryMixRamp.setCurrentAndTargetValue((SampleType)parameters.wetDryMix);
 
-        leftDelayBuffer.createCircularBuffer(delayBufferSize);
-        rightDelayBuffer.createCircularBuffer(delayBufferSize);
+        updateLineDelays();
+        selectKernel(parameters.matrix);
 
         return true;
     }
@@ -415,18 +2524,12 @@ public:
 
     virtual double processAudioSample(double xn) override
     {
-        smoothedDelay -= 0.0005f * (smoothedDelay - parameters.delay);
-        delayInSamples = sampleRate * smoothedDelay;
+        SampleType sample = (SampleType)xn;
+        SampleType* channel = &sample;
 
-        leftDelayBuffer.writeBuffer(xn + leftChannelFeedback);
+        processAudioBlock(&channel, &channel, 1, 1);
 
-        double yn = leftDelayBuffer.readBuffer(delayInSamples);
-
-        leftChannelFeedback = parameters.feedback * yn;
-
-        yn = xn * (1 - parameters.wetDryMix) + (yn * parameters.wetDryMix);
-
-        return yn;
+        return sample;
     }
 
     virtual bool processAudioFrame(const float* inputFrame,
@@ -443,52 +2546,566 @@ public:
         if (outputChannels == 1)
         {
             outputFrame[0] = processAudioSample(inputFrame[0]);
-            outputFrame[1] = outputFrame[0];
             return true;
         }
 
-        // Stereo processing
-        smoothedDelay -= 0.0005f * (smoothedDelay - parameters.delay);
-        delayInSamples = sampleRate * smoothedDelay;
+        // Stereo processing - a block of one frame, in the processing precision
+        SampleType frame[2] = { (SampleType)inputFrame[0], (SampleType)inputFrame[1] };
+        SampleType* channels[2] = { &frame[0], &frame[1] };
+
+        if (!processAudioBlock(channels, channels, 2, 1))
+            return false;
+
+        outputFrame[0] = (float)frame[0];
+        outputFrame[1] = (float)frame[1];
+
+        return true;
+    }
+
+    virtual bool processAudioBlock(const SampleType* const* inputChannels,
+                                   SampleType* const* outputChannels,
+                                   uint32_t numChannels,
+                                   uint32_t numSamples) override
+    {
+        if (numChannels == 0)
+        {
+            return false;
+        }
+
+        const uint32_t channelsToProcess = juce::jmin(numChannels, 2u);
 
-        leftDelayBuffer.writeBuffer(inputFrame[0] + leftChannelFeedback);
-        rightDelayBuffer.writeBuffer(inputFrame[1] + rightChannelFeedback);
+        for (uint32_t chunkStart = 0; chunkStart < numSamples; chunkStart += kChunkSize)
+        {
+            const uint32_t chunkSize = juce::jmin(kChunkSize, numSamples - chunkStart);
+            const SampleType* chunkInputs[2] = { nullptr, nullptr };
+            SampleType* chunkOutputs[2] = { nullptr, nullptr };
+
+            for (uint32_t channel = 0; channel < channelsToProcess; ++channel)
+            {
+                chunkInputs[channel] = inputChannels[channel] + chunkStart;
+                chunkOutputs[channel] = outputChannels[channel] + chunkStart;
+            }
 
-        double leftDelayedSample = leftDelayBuffer.readBuffer(delayInSamples);
-        double rightDelayedSample = rightDelayBuffer.readBuffer(delayInSamples);
+            const RampSpan<SampleType> feedbackValues = feedbackRamp.process(chunkSize);
+            const RampSpan<SampleType> wetDryMixValues = wetDryMixRamp.process(chunkSize);
 
-        leftChannelFeedback = parameters.feedback * leftDelayedSample;
-        rightChannelFeedback = parameters.feedback * rightDelayedSample;
+            (this->*chunkKernel)(chunkInputs, chunkOutputs, channelsToProcess, chunkSize, feedbackValues, wetDryMixValues);
+        }
 
-        outputFrame[0] = inputFrame[0] * (1 - parameters.wetDryMix) + (leftDelayedSample * parameters.wetDryMix);
-        outputFrame[1] = inputFrame[1] * (1 - parameters.wetDryMix) + (rightDelayedSample * parameters.wetDryMix);
         return true;
     }
 
-    AlphaSimpleDelayParameters getParameters()
+    AlphaFeedbackDelayNetworkParameters getParameters()
     {
         return parameters;
     }
 
-    void setParameters(AlphaSimpleDelayParameters _parameters)
+    /** line lengths and the matrix change at the next block; feedback and mix ramp */
+    void setParameters(AlphaFeedbackDelayNetworkParameters _parameters)
     {
+        if (_parameters.matrix != parameters.matrix)
+            selectKernel(_parameters.matrix);
+
         parameters = _parameters;
+
+        feedbackRamp.setTargetValue((SampleType)parameters.feedback);
+        wetDryMixRamp.setTargetValue((SampleType)parameters.wetDryMix);
+
+        updateLineDelays();
     }
 
 private:
-    AlphaSimpleDelayParameters parameters;
+    static constexpr uint32_t kChunkSize = 128;            ///< ramp segment length; at most ParameterRamp<SampleType>::kMaxBlockSize
+    static constexpr double kMaximumDelaySeconds = 1.0;    ///< longest line
+    static constexpr double kGainRampSeconds = 0.020;    ///< feedback and mix ramp time
+
+    /** one sample of every line; sized and aligned to fill whole SIMD registers */
+    struct alignas(sizeof(SampleType) * numLines) LineFrame
+    {
+        SampleType sample[numLines];
+    };
+
+    using Vector = AlphaLaneVector<SampleType, numLines>;
+    static constexpr uint32_t kRegistersPerFrame = numLines / Vector::size;
+
+    /** a LineFrame held in registers; one register unless the frame is wider than the native one */
+    struct FrameVector
+    {
+        typename Vector::Register part[kRegistersPerFrame];
+    };
+
+    static FrameVector loadFrame(const LineFrame& frame)
+    {
+        FrameVector v;
+
+        for (uint32_t r = 0; r < kRegistersPerFrame; ++r)
+            v.part[r] = Vector::load(frame.sample + r * Vector::size);
+
+        return v;
+    }
+
+    static void storeFrame(LineFrame& frame, const FrameVector& v)
+    {
+        for (uint32_t r = 0; r < kRegistersPerFrame; ++r)
+            Vector::store(frame.sample + r * Vector::size, v.part[r]);
+    }
+
+    /** frame * gain, where gain is the same for every line */
+    static FrameVector scale(const FrameVector& frame, typename Vector::Register gain)
+    {
+        FrameVector v;
+
+        for (uint32_t r = 0; r < kRegistersPerFrame; ++r)
+            v.part[r] = Vector::mul(frame.part[r], gain);
+
+        return v;
+    }
+
+    /** a + b * gain, where gain is the same for every line */
+    static FrameVector addScaled(const FrameVector& a, const FrameVector& b, typename Vector::Register gain)
+    {
+        FrameVector v;
+
+        for (uint32_t r = 0; r < kRegistersPerFrame; ++r)
+            v.part[r] = Vector::add(a.part[r], Vector::mul(b.part[r], gain));
+
+        return v;
+    }
+
+    using ChunkKernel = void (AlphaFeedbackDelayNetwork::*)(const SampleType* const*, SampleType* const*, uint32_t, uint32_t,
+                                                            const RampSpan<SampleType>&, const RampSpan<SampleType>&);
+
+    void selectKernel(fdnMatrix matrix)
+    {
+        chunkKernel = matrix == fdnMatrix::kHadamard ? &AlphaFeedbackDelayNetwork::processChunk<fdnMatrix::kHadamard>
+                                                     : &AlphaFeedbackDelayNetwork::processChunk<fdnMatrix::kHouseholder>;
+    }
+
+    /** geometric line lengths from spread * delay up to delay, whole samples, strictly increasing */
+    void updateLineDelays()
+    {
+        // --- not reset( ) yet; it lays the lines out once the sample rate is known
+        if (delayBufferSize <= 0)
+            return;
+
+        const double longest = juce::jlimit(numLines + 1.0, delayBufferSize - 1.0, sampleRate * parameters.delay);
+        const double ratio = juce::jlimit(0.01, 1.0, parameters.spread);
+
+        for (uint32_t line = 0; line < numLines; ++line)
+        {
+            const double exponent = (double)(numLines - 1 - line) / (numLines - 1);
+            lineDelays[line] = juce::jmax((int)(longest * pow(ratio, exponent)), line > 0 ? lineDelays[line - 1] + 1 : 1);
+        }
+    }
+
+    /** normalised Hadamard matrix as log2(N) butterfly stages; builds hadamardColumns */
+    static void mixHadamard(SampleType* frame)
+    {
+        for (uint32_t half = 1; half < numLines; half *= 2)
+        {
+            for (uint32_t start = 0; start < numLines; start += 2 * half)
+            {
+                for (uint32_t line = start; line < start + half; ++line)
+                {
+                    const SampleType a = frame[line];
+                    const SampleType b = frame[line + half];
+                    frame[line] = a + b;
+                    frame[line + half] = a - b;
+                }
+            }
+        }
+
+        const SampleType scale = (SampleType)(1.0 / sqrt((double)numLines));
+
+        for (uint32_t line = 0; line < numLines; ++line)
+            frame[line] *= scale;
+    }
+
+    template <fdnMatrix matrix>
+    void processChunk(const SampleType* const* inputs, SampleType* const* outputs, uint32_t numChannels, uint32_t numSamples,
+                      const RampSpan<SampleType>& feedbackValues, const RampSpan<SampleType>& wetDryMixValues)
+    {
+        // --- each output sums numLines / 2 lines
+        const SampleType outputGain = (SampleType)(1.0 / sqrt(numLines / 2.0));
+        const auto householderScale = Vector::broadcast((SampleType)-2 / numLines);
+
+        const FrameVector leftLanes = loadFrame(leftInputLanes);
+        const FrameVector rightLanes = loadFrame(rightInputLanes);
+        FrameVector columns[numLines];
+
+        if constexpr (matrix == fdnMatrix::kHadamard)
+            for (uint32_t line = 0; line < numLines; ++line)
+                columns[line] = loadFrame(hadamardColumns[line]);
+
+        for (uint32_t i = 0; i < numSamples; ++i)
+        {
+            const SampleType left = inputs[0][i];
+            const SampleType right = inputs[numChannels - 1][i];
+
+            // --- gather: line l was written lineDelays[l] samples ago, so it is one value out of
+            //     that frame; the outputs sum the same values
+            LineFrame delayed;
+            SampleType wetLeft = 0;
+            SampleType wetRight = 0;
+
+            for (uint32_t line = 0; line < numLines; ++line)
+                delayed.sample[line] = lines.getReadPointer(lineDelays[line], 1)->sample[line];
+
+            for (uint32_t line = 0; line < numLines; line += 2)
+            {
+                wetLeft += delayed.sample[line];
+                wetRight += delayed.sample[line + 1];
+            }
+
+            FrameVector mixed;
+
+            if constexpr (matrix == fdnMatrix::kHadamard)
+            {
+                // --- the matrix times the frame as a sum of its columns, one broadcast per line
+                mixed = scale(columns[0], Vector::broadcast(delayed.sample[0]));
+
+                for (uint32_t line = 1; line < numLines; ++line)
+                    mixed = addScaled(mixed, columns[line], Vector::broadcast(delayed.sample[line]));
+            }
+            else
+            {
+                // --- Householder reflection I - 2/N * ones: subtract twice the mean from every line;
+                //     the sum of all lines is what both outputs read
+                FrameVector mean;
+
+                for (uint32_t r = 0; r < kRegistersPerFrame; ++r)
+                    mean.part[r] = Vector::broadcast(wetLeft + wetRight);
+
+                mixed = addScaled(loadFrame(delayed), mean, householderScale);
+            }
+
+            // --- inputs onto their lanes, plus the mixed frame through the feedback gain
+            FrameVector toWrite = addScaled(scale(leftLanes, Vector::broadcast(left)), rightLanes, Vector::broadcast(right));
+            toWrite = addScaled(toWrite, mixed, Vector::broadcast(feedbackValues[i]));
+
+            LineFrame frame;
+            storeFrame(frame, toWrite);
+            lines.writeBuffer(frame);
+
+            const SampleType wet = wetDryMixValues[i];
+            outputs[0][i] = left * (1 - wet) + wetLeft * outputGain * wet;
+
+            if (numChannels > 1)
+                outputs[1][i] = right * (1 - wet) + wetRight * outputGain * wet;
+        }
+    }
+
+    AlphaFeedbackDelayNetworkParameters parameters;
     double sampleRate = 0;
-    double delayInSamples = 0;
-    double smoothedDelay = 0;
-    int delayBufferSize= 0;
-    float readHead = 0;
-    int writeHead = 0;
+    int delayBufferSize = 0;
+    int lineDelays[numLines] = {};    ///< in samples, see updateLineDelays( )
+
+    LineFrame hadamardColumns[numLines];    ///< scaled; see the constructor
+    LineFrame leftInputLanes;            ///< 1 on the lines the left input feeds, 0 elsewhere
+    LineFrame rightInputLanes;
+
+    DelayMemoryArena<LineFrame> delayMemory;    ///< backs the lines
+    CircularBuffer<LineFrame> lines;    ///< all lines, interleaved
+
+    ParameterRamp<SampleType> feedbackRamp;
+    ParameterRamp<SampleType> wetDryMixRamp;
+
+    ChunkKernel chunkKernel = &AlphaFeedbackDelayNetwork::processChunk<fdnMatrix::kHouseholder>;
+};
+
+
+/** a pool of AlphaSimpleDelay engines, one per sounding section. The section being played owns an
+    engine; when playback moves to another section the input is crossfaded (equal power) from the old
+    engine to a free one, and the old engine keeps ringing out with its own parameters. Engines run
+    fully wet; the dry signal and each section's wet level are applied here.
+    With no free engine the oldest tail is stolen: it fades out over the crossfade time and is flushed
+    before the new section starts on it. Engines that are neither owned nor sounding cost nothing */
+template <typename SampleType>
+class AlphaSectionDelayPool
+{
+public:
+    static constexpr int kNoSection = -1;    ///< outside every section: dry only, tails ring out
+    static constexpr uint32_t kDefaultMaxSoundingSections = 4;    ///< the current section and three tails
+
+    AlphaSectionDelayPool() {}        /* C-TOR */
+    ~AlphaSectionDelayPool() {}        /* D-TOR */
+
+    /** create maxSoundingSections engines (the most sections that can sound at once, including
+        tails) and reset them; do NOT call from the realtime audio thread */
+    void prepare(double _sampleRate, uint32_t maxSoundingSections = kDefaultMaxSoundingSections)
+    {
+        sampleRate = _sampleRate;
+
+        engines.resize(juce::jmax(1u, maxSoundingSections));
+
+        for (auto& engine : engines)
+        {
+            if (engine == nullptr)
+                engine.reset(new Engine());
+
+            engine->delay.reset(sampleRate);
+            engine->outputGain.reset(sampleRate, kCrossfadeSeconds, rampShape::kLinear);
+            engine->section = kNoSection;
+            engine->sounding = false;
+            engine->restartPending = false;
+            engine->fadePosition = 0;
+            engine->fadeIncrement = 0;
+        }
+
+        dryGain.reset(sampleRate, kCrossfadeSeconds, rampShape::kLinear);
+        dryGain.setCurrentAndTargetValue(1);
+
+        crossfadeIncrement = (SampleType)(1.0 / juce::jmax(1.0, sampleRate * kCrossfadeSeconds));
+        currentSection = kNoSection;
+        currentEngine = nullptr;
+        sampleCounter = 0;
+    }
+
+    /** silence every engine and forget the current section, e.g. before rendering from a new
+        position; the engines are not reallocated */
+    void reset()
+    {
+        prepare(sampleRate, (uint32_t)engines.size());
+    }
+
+    /** play sectionIndex with these parameters from the next processed sample: a new section
+        crossfades to a free engine, the current one just updates (ramped). Call on the audio thread */
+    void setSection(int sectionIndex, const AlphaSimpleDelayParameters& parameters)
+    {
+        if (sectionIndex == currentSection)
+        {
+            if (currentEngine != nullptr && !isSameSetting(parameters, currentParameters))
+            {
+                // --- a stolen engine still fading out picks the new values up when it starts
+                if (!currentEngine->restartPending)
+                {
+                    currentEngine->delay.setParameters(getEngineParameters(parameters));
+                    currentEngine->outputGain.setTargetValue((SampleType)parameters.wetDryMix);
+                }
+
+                dryGain.setTargetValue((SampleType)(1.0 - parameters.wetDryMix));
+            }
+
+            currentParameters = parameters;
+            return;
+        }
+
+        // --- the old section keeps its tail; only its input fades out
+        if (currentEngine != nullptr)
+        {
+            currentEngine->section = kNoSection;
+            currentEngine->fadeIncrement = -crossfadeIncrement;
+            currentEngine->releasedAtSample = sampleCounter;
+        }
+
+        currentSection = sectionIndex;
+        currentParameters = parameters;
+        currentEngine = sectionIndex != kNoSection ? acquireEngine() : nullptr;
+
+        if (currentEngine != nullptr)
+        {
+            currentEngine->section = sectionIndex;
+
+            if (currentEngine->sounding)
+            {
+                // --- a stolen tail: jumping its parameters would click, so fade it out first;
+                //     processChunk( ) flushes and starts it once it is silent
+                currentEngine->restartPending = true;
+                currentEngine->fadeIncrement = -crossfadeIncrement;
+                currentEngine->outputGain.setTargetValue(0);
+            }
+            else
+            {
+                startEngine(*currentEngine, parameters);
+            }
+        }
+
+        dryGain.setTargetValue(currentEngine != nullptr ? (SampleType)(1.0 - parameters.wetDryMix) : (SampleType)1);
+    }
+
+    /** in place, up to two channels */
+    bool processAudioBlock(SampleType* const* channels, uint32_t numChannels, uint32_t numSamples)
+    {
+        if (numChannels == 0)
+            return false;
+
+        numChannels = juce::jmin(numChannels, 2u);
+
+        for (uint32_t chunkStart = 0; chunkStart < numSamples; chunkStart += kChunkSize)
+        {
+            SampleType* chunk[2] = { channels[0] + chunkStart, channels[numChannels - 1] + chunkStart };
+            processChunk(chunk, numChannels, juce::jmin(kChunkSize, numSamples - chunkStart));
+        }
+
+        sampleCounter += numSamples;
+
+        return true;
+    }
+
+    /** longest tail of the engines that are owned or still sounding */
+    double getTailLengthSeconds() const
+    {
+        double tail = 0.0;
+
+        for (const auto& engine : engines)
+            if (engine->section != kNoSection || engine->sounding)
+                tail = juce::jmax(tail, engine->delay.getTailLengthSeconds());
+
+        return tail;
+    }
+
+private:
+    static constexpr uint32_t kChunkSize = 256;            ///< at most ParameterRamp<SampleType>::kMaxBlockSize
+    static constexpr double kCrossfadeSeconds = 0.030;    ///< section transition
+
+    struct Engine
+    {
+        AlphaSimpleDelay<SampleType> delay;        ///< runs fully wet
+        ParameterRamp<SampleType> outputGain;    ///< the section's wet level
+        int section = kNoSection;                ///< kNoSection once released
+        bool sounding = false;                    ///< owned, or released with a tail that has not died away
+        bool restartPending = false;            ///< stolen while sounding; the old tail is fading out
+        SampleType fadePosition = 0;            ///< input send: 0 = none, 1 = all; the gain is sqrt(fadePosition)
+        SampleType fadeIncrement = 0;            ///< per sample; > 0 fading in, < 0 fading out
+        uint64_t releasedAtSample = 0;            ///< the oldest tail is stolen first
+    };
+
+    static bool isSameSetting(const AlphaSimpleDelayParameters& a, const AlphaSimpleDelayParameters& b)
+    {
+        return a.delay == b.delay && a.feedback == b.feedback && a.wetDryMix == b.wetDryMix
+            && a.damping == b.damping && a.lowCut == b.lowCut;
+    }
+
+    static AlphaSimpleDelayParameters getEngineParameters(AlphaSimpleDelayParameters parameters)
+    {
+        parameters.wetDryMix = 1.0;
+        return parameters;
+    }
+
+    /** start a silent (or flushed) engine on parameters; its send fades in */
+    void startEngine(Engine& engine, const AlphaSimpleDelayParameters& parameters)
+    {
+        engine.sounding = true;
+        engine.restartPending = false;
+        engine.fadeIncrement = crossfadeIncrement;
+        engine.delay.setParameters(getEngineParameters(parameters), false);
+        engine.outputGain.setCurrentAndTargetValue((SampleType)parameters.wetDryMix);
+    }
+
+    /** a silent engine if there is one, otherwise the one whose tail is oldest */
+    Engine* acquireEngine()
+    {
+        Engine* oldest = nullptr;
+
+        for (auto& engine : engines)
+        {
+            if (engine->section != kNoSection)
+                continue;
+
+            if (!engine->sounding)
+                return engine.get();
+
+            if (oldest == nullptr || engine->releasedAtSample < oldest->releasedAtSample)
+                oldest = engine.get();
+        }
+
+        return oldest;
+    }
 
-    float leftChannelFeedback = 0.0;
-    float rightChannelFeedback = 0.0;
+    void processChunk(SampleType* const* channels, uint32_t numChannels, uint32_t numSamples)
+    {
+        SampleType dry[2][kChunkSize];
+        SampleType send[2][kChunkSize];
+        SampleType* sendChannels[2] = { send[0], send[1] };
+
+        for (uint32_t channel = 0; channel < numChannels; ++channel)
+            memcpy(dry[channel], channels[channel], numSamples * sizeof(SampleType));
+
+        const RampSpan<SampleType> dryValues = dryGain.process(numSamples);
+
+        for (uint32_t channel = 0; channel < numChannels; ++channel)
+            for (uint32_t i = 0; i < numSamples; ++i)
+                channels[channel][i] = dry[channel][i] * dryValues[i];
+
+        for (auto& enginePointer : engines)
+        {
+            Engine& engine = *enginePointer;
+
+            // --- released and rung out: skipped entirely
+            if (!engine.sounding)
+                continue;
+
+            buildSend(engine, dry, send, numChannels, numSamples);
+
+            engine.delay.processAudioBlock(sendChannels, sendChannels, numChannels, numSamples);
+
+            const RampSpan<SampleType> gainValues = engine.outputGain.process(numSamples);
+
+            for (uint32_t channel = 0; channel < numChannels; ++channel)
+                for (uint32_t i = 0; i < numSamples; ++i)
+                    channels[channel][i] += send[channel][i] * gainValues[i];
+
+            // --- a stolen engine has faded out: start it on the section that took it, or (if that
+            //     section was left meanwhile) just let it go quiet
+            if (engine.restartPending && engine.outputGain.getCurrentValue() == 0)
+            {
+                engine.delay.flush();
+
+                if (engine.section != kNoSection)
+                {
+                    startEngine(engine, currentParameters);
+                }
+                else
+                {
+                    engine.restartPending = false;
+                    engine.fadePosition = 0;
+                    engine.fadeIncrement = 0;
+                }
+            }
+
+            if (engine.section == kNoSection && engine.fadePosition == 0 && engine.delay.isIdle())
+                engine.sounding = false;
+        }
+    }
+
+    /** the engine's input: the dry signal through its send fade */
+    static void buildSend(Engine& engine, const SampleType (*dry)[kChunkSize], SampleType (*send)[kChunkSize],
+                          uint32_t numChannels, uint32_t numSamples)
+    {
+        if (engine.fadeIncrement == 0)
+        {
+            for (uint32_t channel = 0; channel < numChannels; ++channel)
+            {
+                if (engine.fadePosition > 0)
+                    memcpy(send[channel], dry[channel], numSamples * sizeof(SampleType));
+                else
+                    memset(send[channel], 0, numSamples * sizeof(SampleType));
+            }
+
+            return;
+        }
+
+        for (uint32_t i = 0; i < numSamples; ++i)
+        {
+            engine.fadePosition = juce::jlimit((SampleType)0, (SampleType)1, engine.fadePosition + engine.fadeIncrement);
+            const SampleType gain = std::sqrt(engine.fadePosition);
+
+            for (uint32_t channel = 0; channel < numChannels; ++channel)
+                send[channel][i] = dry[channel][i] * gain;
+        }
 
-    CircularBuffer<float> leftDelayBuffer;
-    CircularBuffer<float> rightDelayBuffer;
+        if (engine.fadePosition == 0 || engine.fadePosition == 1)
+            engine.fadeIncrement = 0;
+    }
+
+    double sampleRate = 0;
+    std::vector<std::unique_ptr<Engine>> engines;
+    Engine* currentEngine = nullptr;            ///< owned by currentSection, if any
+    int currentSection = kNoSection;
+    AlphaSimpleDelayParameters currentParameters;
+    ParameterRamp<SampleType> dryGain;
+    SampleType crossfadeIncrement = 0;
+    uint64_t sampleCounter = 0;
 };
 
 
@@ -502,6 +3119,8 @@ struct AlphaChorusParameters
             feedback = parameters.feedback;
             rate = parameters.rate;
             depth = parameters.depth;
+            interpolation = parameters.interpolation;
+            modulationInterval = parameters.modulationInterval;
         }
 
         return *this;
@@ -511,21 +3130,40 @@ struct AlphaChorusParameters
     double feedback = 0.0;
     double rate = 10.0; // Freq. of LFOs in Hz
     double depth = 0.5;
+    interpolationType interpolation = interpolationType::kHermite; // modulated delay read
+    uint32_t modulationInterval = 16; // samples between LFO updates (control rate); 1 = every sample
 };
 
+template <typename SampleType>
 class AlphaChorus : public IAudioSignalProcessor
 {
 public:
+    // --- the overload for the other precision stays visible (and unhandled)
+    using IAudioSignalProcessor::processAudioBlock;
+
     AlphaChorus() {}
     ~AlphaChorus() {}
 
     virtual bool reset(double _sampleRate) override
     {
         sampleRate = _sampleRate;
-        delayBufferSize = (sampleRate * 2) + 1;
+        delayBufferSize = (sampleRate * kMaximumDelaySeconds) + kLineGuardSamples;
 
-        leftDelayBuffer.createCircularBuffer(delayBufferSize);
-        rightDelayBuffer.createCircularBuffer(delayBufferSize);
+        // --- both lines come from the arena; only the first reset( ) allocates. They only have to hold
+        //     the longest modulated delay, a chunk and the interpolator's taps; the copy after each line
+        //     covers the widest interpolator, so its taps never wrap
+        delayMemory.prepare(2, kMaximumDelaySeconds, sampleRate, kLineGuardSamples, kWidestInterpolatorTaps);
+        leftDelayBuffer.attachToMemory(delayMemory.getLine(0), delayMemory.getLineLength(), delayMemory.getWrapCopyLength());
+        rightDelayBuffer.attachToMemory(delayMemory.getLine(1), delayMemory.getLineLength(), delayMemory.getWrapCopyLength());
+
+        leftDelayBuffer.setInterpolationType(parameters.interpolation);
+        rightDelayBuffer.setInterpolationType(parameters.interpolation);
+
+        leftChannelFeedback = 0.0;
+        rightChannelFeedback = 0.0;
+
+        // --- modulation starts from the centre of the delay range
+        leftDelayInSamples = rightDelayInSamples = sampleRate * (kMinimumDelaySeconds + kMaximumDelaySeconds) / 2;
 
         leftLFO.reset(sampleRate);
         rightLFO.reset(sampleRate);
@@ -538,6 +3176,23 @@ public:
         leftLFO.setParameters(leftLfoParams);
         rightLFO.setParameters(rightLfoParams);
 
+        // --- start settled on the current parameters; the LFO rate is applied once per block
+        feedbackRamp.reset(sampleRate, kGainRampSeconds, rampShape::kLinear);
+        wetDryMixRamp.reset(sampleRate, kGainRampSeconds, rampShape::kLinear);
+        depthRamp.reset(sampleRate, kGainRampSeconds, rampShape::kLinear);
+
+        feedbackRamp.setCurrentAndTargetValue((SampleType)parameters.feedback);
+        wetDryMixRamp.setCurrentAndTargetValue((SampleType)parameters.wetDryMix);
+        depthRamp.setCurrentAndTargetValue((SampleType)parameters.depth);
+
+        // --- the shortest chorus delay covers a whole chunk (at any sensible sample rate), so every
+        //     read in a chunk precedes its writes: the chunk is read with one batched gather and
+        //     written as one block
+        canWriteBlocks = sampleRate * kMinimumDelaySeconds >= kLfoChunkSize + 1;
+
+        // --- expect stereo; processAudioBlock( ) re-selects if the channel count differs
+        selectKernel(2, parameters.interpolation);
+
         return true;
     }
 
@@ -548,28 +3203,12 @@ public:
 
     virtual double processAudioSample(double xn) override
     {
-        auto leftLfoParams = leftLFO.getParameters();
-        leftLfoParams.frequency_Hz = parameters.rate;
-        leftLfoParams.waveform = generatorWaveform::kSin;
-        leftLFO.setParameters(leftLfoParams);
-
-        auto leftLfoOutput = leftLFO.renderAudioOutput();
-        auto leftLfoValue = static_cast<float>(leftLfoOutput.normalOutput * parameters.depth);
-
-        // Chorus Effect delay values
-        float leftLfoMapped = juce::jmap(leftLfoValue, -1.0f, 1.0f, 0.005f, 0.030f);
-        leftDelayInSamples = sampleRate * leftLfoMapped;
+        SampleType sample = (SampleType)xn;
+        SampleType* channel = &sample;
 
-        leftReadHead = writeHead - leftDelayInSamples;
+        processAudioBlock(&channel, &channel, 1, 1);
 
-        leftDelayBuffer.writeBuffer(xn + leftChannelFeedback);
-
-        float leftDelayedSample = leftDelayBuffer.readBuffer(leftDelayInSamples);
-        leftChannelFeedback = parameters.feedback * leftDelayedSample;
-
-        float yn = xn * (1 - parameters.wetDryMix) + (leftDelayedSample * parameters.wetDryMix);
-
-        return yn;
+        return sample;
     }
 
     virtual bool processAudioFrame(const float* inputFrame,
@@ -591,42 +3230,60 @@ public:
             return true;
         }
 
-        // Stereo processing
-        auto leftLfoParams = leftLFO.getParameters();
-        leftLfoParams.frequency_Hz = parameters.rate;
-        leftLfoParams.waveform = generatorWaveform::kTriangle;
-        leftLFO.setParameters(leftLfoParams);
+        // Stereo processing - a block of one frame, in the processing precision
+        SampleType frame[2] = { (SampleType)inputFrame[0], (SampleType)inputFrame[1] };
+        SampleType* channels[2] = { &frame[0], &frame[1] };
 
-        auto rightLfoParams = rightLFO.getParameters();
-        rightLfoParams.frequency_Hz = parameters.rate;
-        rightLfoParams.waveform = generatorWaveform::kTriangle;
-        rightLFO.setParameters(rightLfoParams);
+        if (!processAudioBlock(channels, channels, 2, 1))
+            return false;
+
+        outputFrame[0] = (float)frame[0];
+        outputFrame[1] = (float)frame[1];
+
+        return true;
+    }
+
+    virtual bool processAudioBlock(const SampleType* const* inputChannels,
+                                   SampleType* const* outputChannels,
+                                   uint32_t numChannels,
+                                   uint32_t numSamples) override
+    {
+        if (numChannels == 0)
+        {
+            return false;
+        }
+
+        // --- LFO setup once per block instead of once per frame
+        const bool isStereo = numChannels > 1;
+        const generatorWaveform waveform = isStereo ? generatorWaveform::kTriangle : generatorWaveform::kSin;
+        updateLfoParameters(leftLFO, waveform);
+        updateLfoParameters(rightLFO, waveform);
 
-        auto leftLfoOutput = leftLFO.renderAudioOutput();
-        auto leftLfoValue = static_cast<float>(leftLfoOutput.normalOutput * parameters.depth);
+        // --- normally a no-op: the kernel was chosen on reset( ) / setParameters( )
+        const uint32_t channelsToProcess = juce::jmin(numChannels, 2u);
 
-        auto rightLfoOutput = rightLFO.renderAudioOutput();
-        auto rightLfoValue = static_cast<float>(rightLfoOutput.normalOutput * parameters.depth);
+        if (channelsToProcess != kernelChannels)
+            selectKernel(channelsToProcess, parameters.interpolation);
 
-        // Chorus Effect delay values
-        float leftLfoMapped = juce::jmap(leftLfoValue, -1.0f, 1.0f, 0.005f, 0.030f);
-        leftDelayInSamples = sampleRate * leftLfoMapped;
-        float rightLfoMapped = juce::jmap(rightLfoValue, -1.0f, 1.0f, 0.005f, 0.030f);
-        rightDelayInSamples = sampleRate * rightLfoMapped;
+        for (uint32_t chunkStart = 0; chunkStart < numSamples; chunkStart += kLfoChunkSize)
+        {
+            const uint32_t chunkSize = juce::jmin(kLfoChunkSize, numSamples - chunkStart);
+            const SampleType* chunkInputs[2] = { nullptr, nullptr };
+            SampleType* chunkOutputs[2] = { nullptr, nullptr };
 
-        leftReadHead = writeHead - leftDelayInSamples;
-        rightReadHead = writeHead - rightDelayInSamples;
+            for (uint32_t channel = 0; channel < channelsToProcess; ++channel)
+            {
+                chunkInputs[channel] = inputChannels[channel] + chunkStart;
+                chunkOutputs[channel] = outputChannels[channel] + chunkStart;
+            }
 
-        leftDelayBuffer.writeBuffer(inputFrame[0] + leftChannelFeedback);
-        rightDelayBuffer.writeBuffer(inputFrame[1] + rightChannelFeedback);
+            const RampSpan<SampleType> feedbackValues = feedbackRamp.process(chunkSize);
+            const RampSpan<SampleType> wetDryMixValues = wetDryMixRamp.process(chunkSize);
+            const RampSpan<SampleType> depthValues = depthRamp.process(chunkSize);
 
-        float leftDelayedSample = leftDelayBuffer.readBuffer(leftDelayInSamples);
-        leftChannelFeedback = parameters.feedback * leftDelayedSample;
-        float rightDelayedSample = rightDelayBuffer.readBuffer(rightDelayInSamples);
-        rightChannelFeedback = parameters.feedback * rightDelayedSample;
+            (this->*chunkKernel)(chunkInputs, chunkOutputs, chunkSize, feedbackValues, wetDryMixValues, depthValues);
+        }
 
-        outputFrame[0] = inputFrame[0] * (1 - parameters.wetDryMix) + (leftDelayedSample * parameters.wetDryMix);
-        outputFrame[1] = inputFrame[1] * (1 - parameters.wetDryMix) + (rightDelayedSample * parameters.wetDryMix);
         return true;
     }
 
@@ -637,25 +3294,166 @@ public:
 
     void setParameters(AlphaChorusParameters _parameters)
     {
+        // --- a new interpolator type may build its coefficient table; see CircularBuffer::setInterpolationType
+        if (_parameters.interpolation != parameters.interpolation)
+        {
+            leftDelayBuffer.setInterpolationType(_parameters.interpolation);
+            rightDelayBuffer.setInterpolationType(_parameters.interpolation);
+            selectKernel(kernelChannels, _parameters.interpolation);
+        }
+
         parameters = _parameters;
+
+        // --- the lines only reach kMaximumDelaySeconds (plus the guard), i.e. full depth
+        parameters.depth = juce::jlimit(0.0, 1.0, parameters.depth);
+
+        feedbackRamp.setTargetValue((SampleType)parameters.feedback);
+        wetDryMixRamp.setTargetValue((SampleType)parameters.wetDryMix);
+        depthRamp.setTargetValue((SampleType)parameters.depth);
     }
 
 private:
+    static constexpr uint32_t kLfoChunkSize = 64; ///< LFO values are rendered this many samples at a time
+    static constexpr float kMinimumDelaySeconds = 0.005f; ///< modulated delay range, low end
+    static constexpr float kMaximumDelaySeconds = 0.030f; ///< modulated delay range, high end
+    static constexpr unsigned int kWidestInterpolatorTaps = 8; ///< the windowed sinc's
+    static constexpr unsigned int kLineGuardSamples = kLfoChunkSize + kWidestInterpolatorTaps; ///< a block write plus the widest interpolator
+    static constexpr double kGainRampSeconds = 0.020;    ///< feedback, mix and depth ramp time
+
+    using ChunkKernel = void (AlphaChorus::*)(const SampleType* const*, SampleType* const*, uint32_t,
+                                              const RampSpan<SampleType>&, const RampSpan<SampleType>&, const RampSpan<SampleType>&);
+
+    /** point the chunk kernel at the specialisation for numChannels (1 or 2) and the interpolator */
+    void selectKernel(uint32_t numChannels, interpolationType type)
+    {
+        kernelChannels = numChannels;
+        chunkKernel = numChannels == 1 ? selectKernelFor<1>(type) : selectKernelFor<2>(type);
+    }
+
+    template <uint32_t numChannels>
+    static ChunkKernel selectKernelFor(interpolationType type)
+    {
+        switch (type)
+        {
+            case interpolationType::kNone:         return &AlphaChorus::processChunk<numChannels, interpolationType::kNone>;
+            case interpolationType::kLagrange:     return &AlphaChorus::processChunk<numChannels, interpolationType::kLagrange>;
+            case interpolationType::kHermite:      return &AlphaChorus::processChunk<numChannels, interpolationType::kHermite>;
+            case interpolationType::kWindowedSinc: return &AlphaChorus::processChunk<numChannels, interpolationType::kWindowedSinc>;
+            default:                               return &AlphaChorus::processChunk<numChannels, interpolationType::kLinear>;
+        }
+    }
+
+    /** one chunk of at most kLfoChunkSize samples, specialised on channel count and interpolator */
+    template <uint32_t numChannels, interpolationType type>
+    void processChunk(const SampleType* const* inputs, SampleType* const* outputs, uint32_t chunkSize,
+                      const RampSpan<SampleType>& feedbackValues, const RampSpan<SampleType>& wetDryMixValues, const RampSpan<SampleType>& depthValues)
+    {
+        SampleType delays[kLfoChunkSize];
+        SampleType delayed[kLfoChunkSize];
+        SampleType toWrite[kLfoChunkSize];
+
+        for (uint32_t channel = 0; channel < numChannels; ++channel)
+        {
+            const SampleType* input = inputs[channel];
+            SampleType* output = outputs[channel];
+
+            CircularBuffer<SampleType>& delayBuffer = channel == 0 ? leftDelayBuffer : rightDelayBuffer;
+            SampleType& channelFeedback = channel == 0 ? leftChannelFeedback : rightChannelFeedback;
+            SampleType& delayInSamples = channel == 0 ? leftDelayInSamples : rightDelayInSamples;
+
+            renderModulatedDelays(channel == 0 ? leftLFO : rightLFO, delayInSamples, depthValues, delays, chunkSize);
+
+            if (canWriteBlocks)
+            {
+                delayBuffer.template readBlockAs<type>(delays, delayed, chunkSize);
+
+                for (uint32_t i = 0; i < chunkSize; ++i)
+                {
+                    const SampleType wet = wetDryMixValues[i];
+                    const SampleType inputSample = input[i];
+
+                    toWrite[i] = inputSample + channelFeedback;
+                    channelFeedback = feedbackValues[i] * delayed[i];
+
+                    output[i] = inputSample * (1 - wet) + (delayed[i] * wet);
+                }
+
+                delayBuffer.writeBlock(toWrite, chunkSize);
+                continue;
+            }
+
+            for (uint32_t i = 0; i < chunkSize; ++i)
+            {
+                const SampleType wet = wetDryMixValues[i];
+                const SampleType inputSample = input[i];
+
+                delayBuffer.writeBuffer(inputSample + channelFeedback);
+
+                SampleType delayedSample = delayBuffer.template readBufferAs<type>(delays[i]);
+                channelFeedback = feedbackValues[i] * delayedSample;
+
+                output[i] = inputSample * (1 - wet) + (delayedSample * wet);
+            }
+        }
+    }
+
+    /** fill delays[] with the modulated delay in samples; the LFO runs once every modulationInterval
+        samples (control rate) and the delay is interpolated linearly in between.
+        currentDelay carries the delay at the start of the block from one call to the next */
+    void renderModulatedDelays(LFO& lfo, SampleType& currentDelay, const RampSpan<SampleType>& depthValues, SampleType* delays, uint32_t numSamples)
+    {
+        const uint32_t interval = juce::jlimit(1u, kLfoChunkSize, parameters.modulationInterval);
+
+        for (uint32_t segmentStart = 0; segmentStart < numSamples; segmentStart += interval)
+        {
+            const uint32_t segmentLength = juce::jmin(interval, numSamples - segmentStart);
+            const SampleType lfoValue = lfo.renderControlValue(segmentLength) * depthValues[segmentStart + segmentLength - 1];
+
+            // Chorus Effect delay values, at the end of the segment
+            const SampleType lfoMapped = juce::jmap(lfoValue, (SampleType)-1, (SampleType)1,
+                                                    (SampleType)kMinimumDelaySeconds, (SampleType)kMaximumDelaySeconds);
+            const SampleType targetDelay = (SampleType)sampleRate * lfoMapped;
+            const SampleType increment = (targetDelay - currentDelay) / segmentLength;
+
+            for (uint32_t i = 0; i < segmentLength; ++i)
+                delays[segmentStart + i] = currentDelay + increment * (i + 1);
+
+            currentDelay = targetDelay;
+        }
+    }
+
+    void updateLfoParameters(LFO& lfo, generatorWaveform waveform)
+    {
+        auto lfoParams = lfo.getParameters();
+        lfoParams.frequency_Hz = parameters.rate;
+        lfoParams.waveform = waveform;
+        lfo.setParameters(lfoParams);
+    }
+
     AlphaChorusParameters parameters;
     double sampleRate = 0;
-    double leftDelayInSamples = 0;
-    double rightDelayInSamples = 0;
+    SampleType leftDelayInSamples = 0;
+    SampleType rightDelayInSamples = 0;
     int delayBufferSize = 0;
     float leftReadHead = 0;
     float rightReadHead = 0;
     int writeHead = 0;
 
-    float leftChannelFeedback = 0.0;
-    float rightChannelFeedback = 0.0;
+    SampleType leftChannelFeedback = 0.0;
+    SampleType rightChannelFeedback = 0.0;
 
-    CircularBuffer<float> leftDelayBuffer;
-    CircularBuffer<float> rightDelayBuffer;
+    DelayMemoryArena<SampleType> delayMemory;    ///< backs both delay lines
+    CircularBuffer<SampleType> leftDelayBuffer;
+    CircularBuffer<SampleType> rightDelayBuffer;
 
     LFO leftLFO;
     LFO rightLFO;
+
+    ParameterRamp<SampleType> feedbackRamp;
+    ParameterRamp<SampleType> wetDryMixRamp;
+    ParameterRamp<SampleType> depthRamp;
+
+    bool canWriteBlocks = true;        ///< set on reset( ), see there
+    uint32_t kernelChannels = 2;    ///< channel count chunkKernel is specialised for
+    ChunkKernel chunkKernel = &AlphaChorus::processChunk<2, interpolationType::kHermite>;
 };
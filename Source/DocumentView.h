@@ -226,9 +226,8 @@ class PlayheadPositionLabel : public Label,
                               private Timer
 {
 public:
-    PlayheadPositionLabel (PlayHeadState& playHeadStateIn, AmnesiaDemoAudioProcessor& p)
-        : playHeadState (playHeadStateIn),
-          processor(p)
+    PlayheadPositionLabel (PlayHeadState& playHeadStateIn)
+        : playHeadState (playHeadStateIn)
     {
         startTimerHz (30);
     }
@@ -251,9 +250,8 @@ private:
             text += " (stopped)";
 
         setText (text, NotificationType::dontSendNotification);
-        
-        bool isASection = false;
 
+        // Only follows the playhead in the editor; the processor switches sections itself
         for(auto *section: sections)
         {
             int index = sections.indexOf(section);
@@ -265,21 +263,9 @@ private:
                     selectedIndex = index;
                 }
                 
-                processor.setParameter(DELAY, (section->delayValues.beatDelay) * 60.0 / playHeadState.bpm);
-                processor.setParameter(FEEDBACK, section->delayValues.feedback);
-                processor.setParameter(MIX, section->delayValues.mix);
-                
-                isASection = true;
-                
                 break;
             }
         }
-        
-        if(!isASection)
-        {
-//            processor.setParameter(DELAY, 0);
-            processor.setParameter(FEEDBACK, 0);
-        }
     }
 
     // Copied from AudioPluginDemo.h: quick-and-dirty function to format a timecode string
@@ -296,7 +282,6 @@ private:
     }
 
     PlayHeadState& playHeadState;
-    AmnesiaDemoAudioProcessor& processor;
 };
 
 class SectionList: public Component,
@@ -904,7 +889,7 @@ private:
 
 struct WaveformCache : private ARAAudioSource::Listener
 {
-    WaveformCache() : thumbnailCache (20)
+    explicit WaveformCache (AudioSourceBlockCache& blockCacheIn) : blockCache (blockCacheIn), thumbnailCache (20)
     {
     }
 
@@ -933,7 +918,7 @@ struct WaveformCache : private ARAAudioSource::Listener
         auto& result = *thumb;
 
         ++hash;
-        thumb->setReader (new ARAAudioSourceReader (audioSource), hash);
+        thumb->setReader (blockCache.createReader (audioSource).release(), hash);
 
         audioSource->addListener (this);
         thumbnails.emplace (audioSource, std::move (thumb));
@@ -947,6 +932,7 @@ private:
         thumbnails.erase (audioSource);
     }
 
+    AudioSourceBlockCache& blockCache;
     int64 hash = 0;
     AudioFormatManager dummyManager;
     AudioThumbnailCache thumbnailCache;
@@ -1356,10 +1342,11 @@ public:
     DocumentView (ARAEditorView& editorView, PlayHeadState& playHeadState, AudioProcessorValueTreeState& apvts, AmnesiaDemoAudioProcessor& processor)
         : araEditorView (editorView),
           araDocument (*editorView.getDocumentController()->getDocument<ARADocument>()),
+          waveformCache (ARADocumentControllerSpecialisation::getSpecialisedDocumentController<AmnesiaDemoDocumentController> (editorView.getDocumentController())->getBlockCache()),
           rulersView (playHeadState, timeToViewScaling, araDocument),
           overlay (playHeadState, timeToViewScaling),
           delayComponent(sectionTree),
-          playheadPositionLabel (playHeadState, processor)
+          playheadPositionLabel (playHeadState)
     {
         sectionTree = apvts.state.getChildWithName("sections");
         if(sectionTree.isValid())
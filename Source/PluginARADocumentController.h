@@ -11,6 +11,7 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
+#include "Utilities.h"
 
 //==============================================================================
 /**
@@ -21,6 +22,9 @@ public:
     //==============================================================================
     using ARADocumentControllerSpecialisation::ARADocumentControllerSpecialisation;
 
+    /** Decoded audio source samples, shared by the playback renderers and the editor. */
+    AudioSourceBlockCache& getBlockCache() noexcept { return blockCache; }
+
 protected:
     //==============================================================================
     // Override document controller customization methods here
@@ -33,5 +37,7 @@ protected:
 
 private:
     //==============================================================================
+    AudioSourceBlockCache blockCache;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AmnesiaDemoDocumentController)
 };
@@ -9,6 +9,328 @@
 */
 
 #include "PluginARAPlaybackRenderer.h"
+#include "PluginARADocumentController.h"
+
+//==============================================================================
+class ReadAheadPool::Worker  : public juce::Thread
+{
+public:
+    Worker (ReadAheadPool& poolIn, int index)
+        : juce::Thread (juce::String (JucePlugin_Name) + " ARA Sample Reading Thread " + juce::String (index + 1)),
+          pool (poolIn)
+    {
+    }
+
+    void run() override
+    {
+        // Asleep until woken; a worker that finds work wakes another to look as well
+        while (! threadShouldExit())
+        {
+            if (pool.serveMostUrgentReader())
+                continue;
+
+            pool.workAvailable.wait (-1);
+            pool.wakeUpPending = false;
+        }
+
+        // Passes the exit on to the next sleeping worker
+        pool.workAvailable.signal();
+    }
+
+private:
+    ReadAheadPool& pool;
+};
+
+ReadAheadPool::ReadAheadPool()
+{
+    const auto numWorkers = juce::jlimit (2, 8, juce::SystemStats::getNumCpus() / 2);
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        workers.push_back (std::make_unique<Worker> (*this, i));
+        workers.back()->startThread (juce::Thread::Priority::high);  // Above default priority so playback is fluent, but below realtime
+    }
+}
+
+ReadAheadPool::~ReadAheadPool()
+{
+    for (auto& worker : workers)
+        worker->signalThreadShouldExit();
+
+    workAvailable.signal();
+
+    for (auto& worker : workers)
+        worker->stopThread (4000);
+}
+
+void ReadAheadPool::addReader (ReadAheadReader* reader)
+{
+    const std::lock_guard<std::mutex> guard (lock);
+    readers.push_back (reader);
+}
+
+void ReadAheadPool::removeReader (ReadAheadReader* reader)
+{
+    std::unique_lock<std::mutex> guard (lock);
+    readerReleased.wait (guard, [reader] { return ! reader->beingServed; });
+    readers.erase (std::remove (readers.begin(), readers.end(), reader), readers.end());
+}
+
+void ReadAheadPool::wakeUp()
+{
+    if (! wakeUpPending.exchange (true))
+        workAvailable.signal();
+}
+
+bool ReadAheadPool::serveMostUrgentReader()
+{
+    using Work = ReadAheadReader::Work;
+
+    ReadAheadReader* chosen = nullptr;
+    auto chosenWork = Work::none;
+
+    {
+        const std::lock_guard<std::mutex> guard (lock);
+        auto nearest = std::numeric_limits<juce::int64>::max();
+
+        // Filling windows comes first, nearest to the playhead first; letting go of blocks waits
+        // until nothing else is left. Only atomics and worker-side state are looked at here
+        for (auto* reader : readers)
+        {
+            if (reader->beingServed)
+                continue;
+
+            juce::int64 distance = 0;
+            const auto work = reader->getWork (distance);
+
+            if (work == Work::fill ? (chosenWork == Work::fill && distance >= nearest)
+                                   : (work == Work::none || chosen != nullptr))
+                continue;
+
+            chosen = reader;
+            chosenWork = work;
+            nearest = distance;
+        }
+
+        if (chosen == nullptr)
+            return false;
+
+        chosen->beingServed = true;
+    }
+
+    // There may well be more to read than this one block
+    if (chosenWork == Work::fill)
+        workAvailable.signal();
+
+    const auto didPublish = chosen->serve (chosenWork);
+
+    {
+        const std::lock_guard<std::mutex> guard (lock);
+        chosen->beingServed = false;
+    }
+
+    readerReleased.notify_all();
+    return didPublish;
+}
+
+//==============================================================================
+ReadAheadReader::ReadAheadReader (ReadAheadPool& poolIn, AudioSourceBlockCache& cacheIn, juce::ARAAudioSource* audioSourceIn,
+                                  const std::atomic<juce::int64>& playheadSampleIn, juce::int64 readAheadSamplesIn, juce::int64 horizonSamplesIn)
+    : AudioFormatReader (nullptr, "ReadAheadReader"),
+      pool (poolIn),
+      cache (cacheIn),
+      audioSource (audioSourceIn),
+      playheadSample (playheadSampleIn),
+      readAheadSamples (readAheadSamplesIn),
+      horizonSamples (horizonSamplesIn)
+{
+    bitsPerSample = 32;
+    usesFloatingPointData = true;
+    sampleRate = audioSource->getSampleRate();
+    numChannels = (unsigned int) audioSource->getChannelCount();
+    lengthInSamples = audioSource->getSampleCount();
+
+    cache.addAudioSource (audioSource);
+    pool.addReader (this);
+}
+
+ReadAheadReader::~ReadAheadReader()
+{
+    pool.removeReader (this);
+}
+
+void ReadAheadReader::setPlacement (juce::Range<juce::int64> songRange, juce::int64 sourceOffsetIn)
+{
+    songStart = songRange.getStart();
+    songEnd = songRange.getEnd();
+    sourceOffset = sourceOffsetIn;
+
+    pool.wakeUp();
+}
+
+bool ReadAheadReader::getWanted (juce::Range<juce::int64>& blockRange, juce::int64& distance) const
+{
+    const auto playhead = playheadSample.load (std::memory_order_relaxed);
+    const auto start = songStart.load(), end = songEnd.load();
+
+    if (playhead >= end)
+        return false;
+
+    distance = juce::jmax ((juce::int64) 0, start - playhead);
+
+    if (distance > horizonSamples)
+        return false;
+
+    const auto from = juce::jmax (playhead, start);
+    const auto sourceRange = (juce::Range<juce::int64> (from, juce::jmin (end, from + readAheadSamples)) + sourceOffset.load())
+                                 .getIntersectionWith ({ 0, lengthInSamples });
+
+    if (sourceRange.isEmpty())
+        return false;
+
+    constexpr auto blockSize = (juce::int64) AudioSourceBlockCache::blockSize;
+    blockRange = { sourceRange.getStart() / blockSize, (sourceRange.getEnd() - 1) / blockSize + 1 };
+    return true;
+}
+
+ReadAheadReader::Work ReadAheadReader::getWork (juce::int64& distance) const
+{
+    juce::Range<juce::int64> wanted;
+
+    // Out of reach: the blocks it holds can go
+    if (! getWanted (wanted, distance))
+        return served.blocks.empty() && ! hasRetiredWindows ? Work::none : Work::release;
+
+    // The window has to move, or the samples under it changed
+    if (served.contentGeneration != cache.getContentGeneration() || served.firstBlock != wanted.getStart()
+         || (juce::int64) served.blocks.size() != wanted.getLength())
+        return Work::fill;
+
+    if (served.fetchFailed)
+        return Work::none;
+
+    for (const auto& block : served.blocks)
+        if (block == nullptr)
+            return Work::fill;
+
+    return Work::none;
+}
+
+bool ReadAheadReader::serve (Work work)
+{
+    auto next = std::make_unique<BlockWindow>();
+    next->contentGeneration = cache.getContentGeneration();
+
+    juce::Range<juce::int64> wanted;
+    juce::int64 distance = 0;
+
+    if (work == Work::release)
+    {
+        // Only windows the audio thread was still reading are left to delete
+        if (served.blocks.empty())
+        {
+            hasRetiredWindows = ! window.collectGarbage();
+            return false;
+        }
+    }
+    else if (getWanted (wanted, distance))
+    {
+        next->firstBlock = wanted.getStart();
+        next->blocks.resize ((size_t) wanted.getLength());
+
+        // Blocks already in the window carry over, unless the samples have changed since
+        if (served.contentGeneration == next->contentGeneration)
+        {
+            for (size_t i = 0; i < next->blocks.size(); ++i)
+            {
+                const auto indexInServed = next->firstBlock + (juce::int64) i - served.firstBlock;
+
+                if (indexInServed >= 0 && indexInServed < (juce::int64) served.blocks.size())
+                    next->blocks[i] = served.blocks[(size_t) indexInServed];
+            }
+        }
+
+        // One block per pass, so that a region the playhead reaches sooner gets the next turn
+        for (size_t i = 0; i < next->blocks.size(); ++i)
+        {
+            if (next->blocks[i] == nullptr)
+            {
+                next->blocks[i] = cache.fetchBlock (audioSource, next->firstBlock + (juce::int64) i);
+                next->fetchFailed = next->blocks[i] == nullptr;
+                break;
+            }
+        }
+    }
+
+    served = *next;
+    window.publish (std::move (next));
+    hasRetiredWindows = ! window.collectGarbage();
+    return true;
+}
+
+bool ReadAheadReader::readSamples (int* const* destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                                   juce::int64 startSampleInFile, int numSamples)
+{
+    auto* const* dest = reinterpret_cast<float* const*> (destSamples);
+
+    // With a timeout, reading may wait for the host
+    if (readTimeout.load() != 0)
+        return cache.read (audioSource, dest, numDestChannels, startOffsetInDestBuffer, startSampleInFile, numSamples);
+
+    // Realtime reads take what the window holds, without a lock; a miss plays as silence and
+    // hurries the workers along
+    constexpr auto blockSize = AudioSourceBlockCache::blockSize;
+    const auto* current = window.acquire();
+    auto complete = true;
+
+    while (numSamples > 0)
+    {
+        const auto blockIndex = (startSampleInFile >= 0 ? startSampleInFile : startSampleInFile - blockSize + 1) / blockSize;
+        const auto offsetInBlock = (int) (startSampleInFile - blockIndex * blockSize);
+        const auto numInBlock = juce::jmin (numSamples, blockSize - offsetInBlock);
+
+        const AudioSourceBlockCache::Block* block = nullptr;
+
+        if (startSampleInFile >= 0 && startSampleInFile < lengthInSamples)
+        {
+            if (current != nullptr && blockIndex >= current->firstBlock
+                 && blockIndex - current->firstBlock < (juce::int64) current->blocks.size())
+                block = current->blocks[(size_t) (blockIndex - current->firstBlock)].get();
+
+            complete = complete && block != nullptr;
+        }
+
+        for (int channel = 0; channel < numDestChannels; ++channel)
+        {
+            if (dest[channel] == nullptr)
+                continue;
+
+            if (block != nullptr && channel < block->getNumChannels())
+                juce::FloatVectorOperations::copy (dest[channel] + startOffsetInDestBuffer,
+                                                   block->getReadPointer (channel, offsetInBlock), numInBlock);
+            else
+                juce::FloatVectorOperations::clear (dest[channel] + startOffsetInDestBuffer, numInBlock);
+        }
+
+        startOffsetInDestBuffer += numInBlock;
+        startSampleInFile += numInBlock;
+        numSamples -= numInBlock;
+    }
+
+    window.release();
+
+    if (! complete)
+        pool.wakeUp();
+
+    return complete;
+}
+
+//==============================================================================
+AmnesiaDemoPlaybackRenderer::~AmnesiaDemoPlaybackRenderer()
+{
+    if (listenedDocument != nullptr)
+        listenedDocument->removeListener (this);
+}
 
 //==============================================================================
 void AmnesiaDemoPlaybackRenderer::prepareToPlay (double sampleRateIn, int maximumSamplesPerBlockIn, int numChannelsIn, juce::AudioProcessor::ProcessingPrecision, AlwaysNonRealtime alwaysNonRealtime)
@@ -16,138 +338,516 @@ void AmnesiaDemoPlaybackRenderer::prepareToPlay (double sampleRateIn, int maximu
     numChannels = numChannelsIn;
     sampleRate = sampleRateIn;
     maximumSamplesPerBlock = maximumSamplesPerBlockIn;
+
     useBufferedAudioSourceReader = alwaysNonRealtime == AlwaysNonRealtime::no;
-    tempBuffer.reset (new juce::AudioBuffer<float> (numChannels, maximumSamplesPerBlock));
+
+    // Realtime, every region gets its own read-ahead reader instead
+    if (useBufferedAudioSourceReader)
+        audioSourceReaders.clear();
+
+    // Offline, the regions are read ahead in large chunks that the host blocks are served from
+    internalBlockSize = useBufferedAudioSourceReader ? maximumSamplesPerBlock
+                                                     : juce::jmax (maximumSamplesPerBlock, offlineChunkSize);
+    stagedRange = {};
+    sourceJobBuffers.clear();
+    lastWakeUpPlayhead = -readAheadWakeUpInterval;
+
+    tempBuffer.reset (new juce::AudioBuffer<float> (numChannels, internalBlockSize));
+    regionRenders.clear();
+    sequenceRenders.clear();
+
+    std::map<juce::ARAAudioSource*, size_t> sourceIndices;
+    const auto readAheadSize = juce::jmax (4 * maximumSamplesPerBlock, juce::roundToInt (2.0 * sampleRate));
+    const auto readAheadHorizon = juce::roundToInt (readAheadHorizonSeconds * sampleRate);
+    auto& blockCache = juce::ARADocumentControllerSpecialisation::getSpecialisedDocumentController<AmnesiaDemoDocumentController> (getDocumentController())->getBlockCache();
+
     for (const auto playbackRegion : getPlaybackRegions())
     {
         auto audioSource = playbackRegion->getAudioModification()->getAudioSource();
 
-        if (audioSourceReaders.find (audioSource) == audioSourceReaders.end())
+        auto& sequence = sequenceRenders[playbackRegion->getRegionSequence()];
+
+        if (sequence.delay == nullptr)
         {
-            auto reader = std::make_unique<juce::ARAAudioSourceReader> (audioSource);
+            sequence.buffer.setSize (numChannels, internalBlockSize);
+            sequence.delay = std::make_unique<AlphaSectionDelayPool<float>>();
+            sequence.delay->prepare (sampleRate);
+        }
 
-            if (! useBufferedAudioSourceReader)
-            {
-                audioSourceReaders.emplace (audioSource,
-                                            PossiblyBufferedReader { std::move (reader) });
-            }
-            else
-            {
-                const auto readAheadSize = juce::jmax (4 * maximumSamplesPerBlock,
-                                                 juce::roundToInt (2.0 * sampleRate));
-                audioSourceReaders.emplace (audioSource,
-                                            PossiblyBufferedReader { std::make_unique<juce::BufferingAudioReader> (reader.release(),
-                                                                                                             *sharedTimesliceThread,
-                                                                                                             readAheadSize) });
-            }
+        regionRenders.push_back (std::make_unique<RegionRender>());
+        auto* region = regionRenders.back().get();
+        region->playbackRegion = playbackRegion;
+        region->sequence = &sequence;
+        region->sourceIndex = sourceIndices.emplace (audioSource, sourceIndices.size()).first->second;
+
+        // Samples come through the document's block cache, shared with the other renderers and the editor
+        if (useBufferedAudioSourceReader)
+        {
+            // Per region, so that the read-ahead pool can tell how soon the playhead gets to it
+            auto reader = std::make_unique<ReadAheadReader> (*readAheadPool, blockCache, audioSource, playheadSample,
+                                                             readAheadSize, readAheadHorizon);
+            region->readAhead = reader.get();
+            region->reader = PossiblyBufferedReader { std::move (reader) };
+        }
+        else if (audioSourceReaders.find (audioSource) == audioSourceReaders.end())
+        {
+            audioSourceReaders.emplace (audioSource,
+                                        PossiblyBufferedReader { blockCache.createReader (audioSource) });
+        }
+    }
+
+    // Offline bounces spread reading and the per-sequence delays over the cores
+    if (useBufferedAudioSourceReader)
+        renderThreads.reset();
+    else if (renderThreads == nullptr)
+        renderThreads = std::make_unique<juce::ThreadPool> (juce::jmax (1, juce::SystemStats::getNumCpus()));
+
+    hits.reserve (regionRenders.size());
+    sourceJobStarts.reserve (sourceIndices.size() + 1);
+    sequenceJobs.clear();
+
+    for (auto& sequence : sequenceRenders)
+        sequenceJobs.push_back (&sequence.second);
+
+    // Offline, the sources are read side by side, each job into its own scratch buffer
+    if (! useBufferedAudioSourceReader)
+        for (size_t i = 0; i < sourceIndices.size(); ++i)
+            sourceJobBuffers.emplace_back (numChannels, internalBlockSize);
+
+    // Region positions only change in document edits; the index follows them from there
+    if (listenedDocument == nullptr)
+    {
+        listenedDocument = getDocumentController()->getDocument<juce::ARADocument>();
+        listenedDocument->addListener (this);
+    }
+
+    regionIndex.publish (createRegionIndex());
+}
+
+void AmnesiaDemoPlaybackRenderer::didEndEditing (juce::ARADocument*)
+{
+    regionIndex.publish (createRegionIndex());
+}
+
+std::unique_ptr<AmnesiaDemoPlaybackRenderer::RegionIndex> AmnesiaDemoPlaybackRenderer::createRegionIndex()
+{
+    auto index = std::make_unique<RegionIndex>();
+    index->regions.reserve (regionRenders.size());
+
+    for (const auto& region : regionRenders)
+    {
+        auto* playbackRegion = region->playbackRegion;
+
+        // Evaluate region borders in song time, calculate sample range to render in song time.
+        // Note that this example does not use head- or tailtime, so the includeHeadAndTail
+        // parameter is set to false here - this might need to be adjusted in actual plug-ins.
+        const auto playbackSampleRange = playbackRegion->getSampleRange (sampleRate, juce::ARAPlaybackRegion::IncludeHeadAndTail::no);
+
+        // Evaluate region borders in modification/source time and calculate offset between
+        // song and source samples, then clip song samples accordingly
+        // (if an actual plug-in supports time stretching, this must be taken into account here).
+        juce::Range<juce::int64> modificationSampleRange { playbackRegion->getStartInAudioModificationSamples(),
+                                               playbackRegion->getEndInAudioModificationSamples() };
+        const auto songRange = playbackSampleRange.getIntersectionWith (modificationSampleRange.movedToStartAt (playbackSampleRange.getStart()));
+
+        if (songRange.isEmpty())
+            continue;
+
+        const auto sourceOffset = modificationSampleRange.getStart() - playbackSampleRange.getStart();
+        PossiblyBufferedReader* reader = nullptr;
+
+        // Realtime, the region's own reader; offline, the one of its audio source
+        if (region->readAhead != nullptr)
+        {
+            region->readAhead->setPlacement (songRange, sourceOffset);
+            reader = &region->reader;
+        }
+        else
+        {
+            const auto readerIt = audioSourceReaders.find (playbackRegion->getAudioModification()->getAudioSource());
+
+            if (readerIt != audioSourceReaders.end())
+                reader = &readerIt->second;
         }
+
+        index->regions.push_back ({ songRange, sourceOffset, region.get(), reader });
     }
 
+    std::sort (index->regions.begin(), index->regions.end(), [] (const IndexedRegion& a, const IndexedRegion& b)
+    {
+        return a.songRange.getStart() < b.songRange.getStart();
+    });
+
+    index->buildTree();
+    return index;
+}
+
+juce::int64 AmnesiaDemoPlaybackRenderer::RegionIndex::buildSubtree (size_t begin, size_t end)
+{
+    if (begin >= end)
+        return std::numeric_limits<juce::int64>::lowest();
+
+    const auto middle = begin + (end - begin) / 2;
+
+    subtreeMaxEnds[middle] = juce::jmax (regions[middle].songRange.getEnd(), buildSubtree (begin, middle), buildSubtree (middle + 1, end));
+    return subtreeMaxEnds[middle];
+}
+
+void AmnesiaDemoPlaybackRenderer::RegionIndex::findIntersecting (juce::Range<juce::int64> range,
+                                                                 std::vector<const IndexedRegion*>& hits) const
+{
+    findIntersecting (range, hits, 0, regions.size());
+}
+
+void AmnesiaDemoPlaybackRenderer::RegionIndex::findIntersecting (juce::Range<juce::int64> range, std::vector<const IndexedRegion*>& hits,
+                                                                 size_t begin, size_t end) const
+{
+    // Nothing here reaches into the range: O(log n + hits) nodes are visited in all
+    if (begin >= end)
+        return;
+
+    const auto middle = begin + (end - begin) / 2;
+
+    if (subtreeMaxEnds[middle] <= range.getStart())
+        return;
+
+    findIntersecting (range, hits, begin, middle);
+
+    // The right half starts no earlier than the middle, so past the range it can be skipped too
+    if (regions[middle].songRange.getStart() >= range.getEnd())
+        return;
+
+    if (regions[middle].songRange.getEnd() > range.getStart())
+        hits.push_back (&regions[middle]);
+
+    findIntersecting (range, hits, middle + 1, end);
 }
 
 void AmnesiaDemoPlaybackRenderer::releaseResources()
 {
 }
 
+double AmnesiaDemoPlaybackRenderer::getDelayTailLengthSeconds() const
+{
+    double tail = 0.0;
+
+    for (const auto& sequence : sequenceRenders)
+        tail = juce::jmax (tail, sequence.second.delay->getTailLengthSeconds());
+
+    return tail;
+}
+
 //==============================================================================
 bool AmnesiaDemoPlaybackRenderer::processBlock (juce::AudioBuffer<float>& buffer,
                                                        juce::AudioProcessor::Realtime realtime,
                                                        const juce::AudioPlayHead::PositionInfo& positionInfo) noexcept
 {
     const auto numSamples = buffer.getNumSamples();
-    jassert (numSamples <= maximumSamplesPerBlock);
     jassert (numChannels == buffer.getNumChannels());
     jassert (realtime == juce::AudioProcessor::Realtime::no || useBufferedAudioSourceReader);
     const auto timeInSamples = positionInfo.getTimeInSamples().orFallback (0);
     const auto isPlaying = positionInfo.getIsPlaying();
+    playheadSample.store (timeInSamples, std::memory_order_relaxed);
 
+    // The read-ahead sleeps until the playhead has moved on or jumped far enough to matter
+    if (useBufferedAudioSourceReader && std::abs (timeInSamples - lastWakeUpPlayhead) >= readAheadWakeUpInterval)
+    {
+        lastWakeUpPlayhead = timeInSamples;
+        readAheadPool->wakeUp();
+    }
+
+    sectionContext.secondsPerBeat = 60.0 / positionInfo.getBpm().orFallback (120.0);
+
+    if (! useBufferedAudioSourceReader && isPlaying)
+        return renderFromStaging (buffer, timeInSamples);
+
+    // The sequence buffers are read into below, so what they held no longer follows on
+    stagedRange = {};
+
+    // Blocks larger than prepared for are rendered in pieces
     bool success = true;
-    bool didRenderAnyRegion = false;
 
-    if (isPlaying)
+    for (int start = 0; start < numSamples; start += internalBlockSize)
     {
-        const auto blockRange = juce::Range<juce::int64>::withStartAndLength (timeInSamples, numSamples);
+        juce::AudioBuffer<float> chunk (buffer.getArrayOfWritePointers(), buffer.getNumChannels(),
+                                        start, juce::jmin (internalBlockSize, numSamples - start));
+
+        success = renderBlock (chunk, timeInSamples + start, realtime, isPlaying) && success;
+    }
 
-        for (const auto& playbackRegion : getPlaybackRegions())
+    return success;
+}
+
+bool AmnesiaDemoPlaybackRenderer::renderFromStaging (juce::AudioBuffer<float>& buffer, juce::int64 timeInSamples)
+{
+    const auto numSamples = buffer.getNumSamples();
+
+    // A bounce asks for the blocks in order, so each one is staged already or follows on from the
+    // staged chunk; anything else (a jump, a restart) stages afresh from here
+    if (stagedRange.isEmpty() || timeInSamples < stagedRange.getStart() || timeInSamples > stagedRange.getEnd())
+        stagedRange = juce::Range<juce::int64>::withStartAndLength (timeInSamples, 0);
+
+    // Only the regions' samples are staged. The delays run on each host block's part of the chunk
+    // with that block's sections and base parameters, so automation lands where it does in realtime
+    // and not once per chunk
+    bool success = true;
+
+    for (int done = 0; done < numSamples;)
+    {
+        const auto position = timeInSamples + done;
+
+        if (position >= stagedRange.getEnd())
         {
-            // Evaluate region borders in song time, calculate sample range to render in song time.
-            // Note that this example does not use head- or tailtime, so the includeHeadAndTail
-            // parameter is set to false here - this might need to be adjusted in actual plug-ins.
-            const auto playbackSampleRange = playbackRegion->getSampleRange (sampleRate, juce::ARAPlaybackRegion::IncludeHeadAndTail::no);
-            auto renderRange = blockRange.getIntersectionWith (playbackSampleRange);
+            stagedRange = juce::Range<juce::int64>::withStartAndLength (stagedRange.getEnd(), internalBlockSize);
+            readSequences (stagedRange, juce::AudioProcessor::Realtime::no, true);
+        }
 
-            if (renderRange.isEmpty())
-                continue;
+        const auto startInStaging = (int) (position - stagedRange.getStart());
+        const auto numInPart = juce::jmin (numSamples - done, (int) (stagedRange.getEnd() - position));
+        juce::AudioBuffer<float> part (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), done, numInPart);
 
-            // Evaluate region borders in modification/source time and calculate offset between
-            // song and source samples, then clip song samples accordingly
-            // (if an actual plug-in supports time stretching, this must be taken into account here).
-            juce::Range<juce::int64> modificationSampleRange { playbackRegion->getStartInAudioModificationSamples(),
-                                                   playbackRegion->getEndInAudioModificationSamples() };
-            const auto modificationSampleOffset = modificationSampleRange.getStart() - playbackSampleRange.getStart();
+        auto context = sectionContext;
+        context.blockStartTime = (double) position / sampleRate;
 
-            renderRange = renderRange.getIntersectionWith (modificationSampleRange.movedToStartAt (playbackSampleRange.getStart()));
+        success = runSequenceDelays (part, startInStaging, context) && success;
+        done += numInPart;
+    }
 
-            if (renderRange.isEmpty())
-                continue;
+    return success;
+}
 
-            // Get the audio source for the region and find the reader for that source.
-            // This simplified example code only produces audio if sample rate and channel count match -
-            // a robust plug-in would need to do conversion, see ARA SDK documentation.
-            const auto audioSource = playbackRegion->getAudioModification()->getAudioSource();
-            const auto readerIt = audioSourceReaders.find (audioSource);
+bool AmnesiaDemoPlaybackRenderer::renderBlock (juce::AudioBuffer<float>& buffer, juce::int64 timeInSamples,
+                                               juce::AudioProcessor::Realtime realtime, bool isPlaying)
+{
+    const auto numSamples = buffer.getNumSamples();
+    jassert (numSamples <= internalBlockSize);
 
-            if (readerIt == audioSourceReaders.end())
-            {
-                success = false;
-                continue;
-            }
+    readSequences (juce::Range<juce::int64>::withStartAndLength (timeInSamples, numSamples), realtime, isPlaying);
 
-            auto& reader = readerIt->second;
-            reader.setReadTimeout (realtime == juce::AudioProcessor::Realtime::no ? 100 : 0);
+    // Sections are found on the same song time as the regions, wherever this chunk starts
+    auto context = sectionContext;
+    context.blockStartTime = (double) timeInSamples / sampleRate;
 
-            // Calculate buffer offsets.
-            const int numSamplesToRead = (int) renderRange.getLength();
-            const int startInBuffer = (int) (renderRange.getStart() - blockRange.getStart());
-            auto startInSource = renderRange.getStart() + modificationSampleOffset;
+    return runSequenceDelays (buffer, 0, context);
+}
 
-            // Read samples:
-            // first region can write directly into output, later regions need to use local buffer.
-            auto& readBuffer = (didRenderAnyRegion) ? *tempBuffer : buffer;
+void AmnesiaDemoPlaybackRenderer::readSequences (juce::Range<juce::int64> blockRange,
+                                                 juce::AudioProcessor::Realtime realtime, bool isPlaying)
+{
+    jassert (blockRange.getLength() <= internalBlockSize);
 
-            if (! reader.get()->read (&readBuffer, startInBuffer, numSamplesToRead, startInSource, true, true))
-            {
-                success = false;
-                continue;
-            }
+    // Only the regions this block touches, found through the index
+    hits.clear();
 
-            // Mix output of all regions
-            if (didRenderAnyRegion)
-            {
-                // Mix local buffer into the output buffer.
-                for (int c = 0; c < numChannels; ++c)
-                    buffer.addFrom (c, startInBuffer, *tempBuffer, c, startInBuffer, numSamplesToRead);
-            }
-            else
-            {
-                // Clear any excess at start or end of the region.
-                if (startInBuffer != 0)
-                    buffer.clear (0, startInBuffer);
+    if (const auto* index = regionIndex.acquire(); index != nullptr && isPlaying)
+        index->findIntersecting (blockRange, hits);
+
+    // Each region sequence is summed on its own and later runs through its own delay, so
+    // overlapping regions on different sequences never share a feedback loop
+    if (renderThreads != nullptr && hits.size() > 1)
+    {
+        readInParallel (blockRange);
+    }
+    else
+    {
+        for (auto& sequence : sequenceRenders)
+            readSequenceSerially (sequence.second, blockRange, realtime);
+    }
+}
 
-                const int endInBuffer = startInBuffer + numSamplesToRead;
-                const int remainingSamples = numSamples - endInBuffer;
+bool AmnesiaDemoPlaybackRenderer::runSequenceDelays (juce::AudioBuffer<float>& buffer, int startInSequences,
+                                                     const SectionedDelayContext& context)
+{
+    const auto numSamples = buffer.getNumSamples();
 
-                if (remainingSamples != 0)
-                    buffer.clear (endInBuffer, remainingSamples);
+    auto runDelay = [this, startInSequences, numSamples, &context] (SequenceRender& sequence)
+    {
+        juce::AudioBuffer<float> part (sequence.buffer.getArrayOfWritePointers(), numChannels, startInSequences, numSamples);
 
-                didRenderAnyRegion = true;
-            }
+        processSectionedDelay (*sequence.delay, part.getArrayOfWritePointers(),
+                               (uint32_t) numChannels, numSamples, context);
+    };
+
+    // Offline, one job per sequence
+    if (renderThreads != nullptr && sequenceJobs.size() > 1)
+    {
+        runInParallel ((int) sequenceJobs.size(), [this, &runDelay] (int job) { runDelay (*sequenceJobs[(size_t) job]); });
+    }
+    else
+    {
+        for (auto& sequence : sequenceRenders)
+            runDelay (sequence.second);
+    }
+
+    bool success = true;
+    buffer.clear();
+
+    for (auto& sequence : sequenceRenders)
+    {
+        for (int c = 0; c < numChannels; ++c)
+            buffer.addFrom (c, 0, sequence.second.buffer, c, startInSequences, numSamples);
+
+        success = success && sequence.second.success;
+    }
+
+    return success;
+}
+
+bool AmnesiaDemoPlaybackRenderer::readRegion (const IndexedRegion& indexed, juce::AudioBuffer<float>& destination,
+                                              juce::Range<juce::int64> blockRange, juce::AudioProcessor::Realtime realtime)
+{
+    auto& region = *indexed.region;
+    region.rendered = {};
+
+    // This simplified example code only produces audio if sample rate and channel count match -
+    // a robust plug-in would need to do conversion, see ARA SDK documentation.
+    if (indexed.reader == nullptr)
+        return false;
+
+    const auto renderRange = blockRange.getIntersectionWith (indexed.songRange);
+
+    if (renderRange.isEmpty())
+        return true;
+
+    auto& reader = *indexed.reader;
+    reader.setReadTimeout (realtime == juce::AudioProcessor::Realtime::no ? 100 : 0);
+
+    // Calculate buffer offsets.
+    const int numSamplesToRead = (int) renderRange.getLength();
+    const int startInBuffer = (int) (renderRange.getStart() - blockRange.getStart());
+    auto startInSource = renderRange.getStart() + indexed.sourceOffset;
+
+    if (! reader.get()->read (&destination, startInBuffer, numSamplesToRead, startInSource, true, true))
+        return false;
+
+    region.rendered = juce::Range<int>::withStartAndLength (startInBuffer, numSamplesToRead);
+    return true;
+}
+
+void AmnesiaDemoPlaybackRenderer::readSequenceSerially (SequenceRender& sequence, juce::Range<juce::int64> blockRange,
+                                                        juce::AudioProcessor::Realtime realtime)
+{
+    const auto numSamples = (int) blockRange.getLength();
+    bool didRenderAnyRegion = false;
+    sequence.success = true;
+
+    for (const auto* indexed : hits)
+    {
+        if (indexed->region->sequence != &sequence)
+            continue;
+
+        // Read samples:
+        // first region can write directly into the sequence buffer, later regions need to use local buffer.
+        auto& readBuffer = (didRenderAnyRegion) ? *tempBuffer : sequence.buffer;
+
+        if (! readRegion (*indexed, readBuffer, blockRange, realtime))
+        {
+            sequence.success = false;
+            continue;
+        }
+
+        const auto rendered = indexed->region->rendered;
+
+        if (rendered.isEmpty())
+            continue;
+
+        // Mix output of all regions of the sequence
+        if (didRenderAnyRegion)
+        {
+            // Mix local buffer into the sequence buffer.
+            for (int c = 0; c < numChannels; ++c)
+                sequence.buffer.addFrom (c, rendered.getStart(), *tempBuffer, c, rendered.getStart(), rendered.getLength());
+        }
+        else
+        {
+            // Clear any excess at start or end of the region.
+            if (rendered.getStart() != 0)
+                sequence.buffer.clear (0, rendered.getStart());
+
+            const int remainingSamples = numSamples - rendered.getEnd();
+
+            if (remainingSamples != 0)
+                sequence.buffer.clear (rendered.getEnd(), remainingSamples);
+
+            didRenderAnyRegion = true;
         }
     }
 
-    // If no playback or no region did intersect, clear buffer now.
+    // Nothing of this sequence in the block: only its delay tail, if any, is left
     if (! didRenderAnyRegion)
-        buffer.clear();
+        sequence.buffer.clear (0, numSamples);
+}
 
-    return success;
+void AmnesiaDemoPlaybackRenderer::readInParallel (juce::Range<juce::int64> blockRange)
+{
+    const auto numSamples = (int) blockRange.getLength();
+
+    // One job per audio source among the hits; each job reads its regions one after
+    // another into its own scratch buffer and adds them into their sequences
+    std::sort (hits.begin(), hits.end(), [] (const IndexedRegion* a, const IndexedRegion* b)
+    {
+        return a->region->sourceIndex < b->region->sourceIndex;
+    });
+
+    sourceJobStarts.clear();
+
+    for (size_t i = 0; i < hits.size(); ++i)
+        if (i == 0 || hits[i]->region->sourceIndex != hits[i - 1]->region->sourceIndex)
+            sourceJobStarts.push_back (i);
+
+    sourceJobStarts.push_back (hits.size());
+
+    for (auto& sequence : sequenceRenders)
+    {
+        sequence.second.buffer.clear (0, numSamples);
+        sequence.second.success = true;
+    }
+
+    runInParallel ((int) sourceJobStarts.size() - 1, [this, blockRange] (int job)
+    {
+        auto& scratch = sourceJobBuffers[(size_t) job];
+
+        for (auto i = sourceJobStarts[(size_t) job]; i < sourceJobStarts[(size_t) job + 1]; ++i)
+        {
+            const auto& region = *hits[i]->region;
+            const auto success = readRegion (*hits[i], scratch, blockRange, juce::AudioProcessor::Realtime::no);
+            const std::lock_guard<std::mutex> guard (region.sequence->mixLock);
+
+            region.sequence->success = region.sequence->success && success;
+
+            if (region.rendered.isEmpty())
+                continue;
+
+            for (int c = 0; c < numChannels; ++c)
+                juce::FloatVectorOperations::add (region.sequence->buffer.getWritePointer (c, region.rendered.getStart()),
+                                                  scratch.getReadPointer (c, region.rendered.getStart()),
+                                                  region.rendered.getLength());
+        }
+    });
+}
+
+void AmnesiaDemoPlaybackRenderer::runInParallel (int numJobs, const std::function<void (int)>& job)
+{
+    // The calling thread takes the last job itself and then waits for the rest
+    if (numJobs <= 0)
+        return;
+
+    std::atomic<int> remaining { numJobs - 1 };
+    juce::WaitableEvent finished;
+
+    for (int i = 0; i < numJobs - 1; ++i)
+    {
+        renderThreads->addJob ([&, i]
+        {
+            job (i);
+
+            if (--remaining == 0)
+                finished.signal();
+        });
+    }
+
+    job (numJobs - 1);
+
+    if (numJobs > 1)
+        finished.wait();
 }
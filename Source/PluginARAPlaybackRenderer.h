@@ -11,18 +11,109 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <condition_variable>
+#include "Utilities.h"
 //==============================================================================
 /**
 */
 
-class SharedTimeSliceThread  : public juce::TimeSliceThread
+class ReadAheadReader;
+
+/** Worker threads that read source samples ahead of the playhead into the block cache and hand
+    them to their readers, shared by every renderer in the process.
+
+    Each pass serves the reader whose region the playhead reaches soonest, so with hundreds of
+    regions the ones about to play still come first. Readers whose regions lie beyond their horizon,
+    or behind the playhead, are left alone until it gets close; the blocks they hold are let go of
+    once nothing more urgent is left. Workers sleep until woken: by the renderer as the playhead
+    moves on, by a realtime read that missed, or by a region moving on the timeline.
+*/
+class ReadAheadPool
 {
 public:
-    SharedTimeSliceThread()
-        : juce::TimeSliceThread (juce::String (JucePlugin_Name) + " ARA Sample Reading Thread")
+    ReadAheadPool();
+    ~ReadAheadPool();
+
+    void addReader (ReadAheadReader* reader);
+    /** Waits for a worker still reading for it to finish. */
+    void removeReader (ReadAheadReader* reader);
+
+    /** Has the workers look for work. Fine on the audio thread: until a worker has woken up,
+        further calls only test a flag. */
+    void wakeUp();
+
+private:
+    class Worker;
+
+    bool serveMostUrgentReader();
+
+    std::mutex lock; ///< Guards readers and their beingServed flags.
+    std::condition_variable readerReleased;
+    std::vector<ReadAheadReader*> readers;
+    juce::WaitableEvent workAvailable; ///< Wakes one sleeping worker per signal.
+    std::atomic<bool> wakeUpPending { false }; ///< Set by wakeUp(), cleared by the worker it woke.
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    JUCE_DECLARE_NON_COPYABLE (ReadAheadPool)
+};
+
+/** Reads a playback region's audio source for realtime playback, from blocks the ReadAheadPool
+    has read into the block cache ahead of the playhead.
+
+    Without a read timeout, reads never wait and never lock: they copy from the window of blocks a
+    worker publishes for the region, and samples that aren't in it yet read as silence. The audio
+    thread never frees a block either; windows it has let go of are deleted by the workers. With a
+    read timeout, reads go through the cache and fetch from the host if need be.
+*/
+class ReadAheadReader  : public juce::AudioFormatReader
+{
+public:
+    ReadAheadReader (ReadAheadPool& poolIn, AudioSourceBlockCache& cacheIn, juce::ARAAudioSource* audioSourceIn,
+                     const std::atomic<juce::int64>& playheadSampleIn, juce::int64 readAheadSamplesIn, juce::int64 horizonSamplesIn);
+    ~ReadAheadReader() override;
+
+    /** Where the region plays, in song samples, and the offset from song to source samples. */
+    void setPlacement (juce::Range<juce::int64> songRange, juce::int64 sourceOffset);
+    void setReadTimeout (int ms) { readTimeout = ms; }
+
+    bool readSamples (int* const* destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                      juce::int64 startSampleInFile, int numSamples) override;
+
+private:
+    friend class ReadAheadPool;
+
+    /** Consecutive blocks of the source from firstBlock on; nullptr where not fetched (yet). */
+    struct BlockWindow
     {
-        startThread (Priority::high);  // Above default priority so playback is fluent, but below realtime
-    }
+        juce::int64 firstBlock = 0;
+        std::vector<std::shared_ptr<const AudioSourceBlockCache::Block>> blocks;
+        juce::uint32 contentGeneration = 0; ///< The cache's, from before the blocks were fetched.
+        bool fetchFailed = false; ///< The host couldn't deliver; not tried again until the window moves.
+    };
+
+    enum class Work { none, fill, release };
+
+    /** The source blocks to have in the window next and how many song samples the playhead is
+        still away from them; false if the region is behind the playhead or beyond the horizon. */
+    bool getWanted (juce::Range<juce::int64>& blockRange, juce::int64& distance) const;
+    /** Pool lock held, not being served. */
+    Work getWork (juce::int64& distance) const;
+    /** Worker thread, being served; true if a window was published. */
+    bool serve (Work work);
+
+    ReadAheadPool& pool;
+    AudioSourceBlockCache& cache;
+    juce::ARAAudioSource* audioSource;
+    const std::atomic<juce::int64>& playheadSample;
+    const juce::int64 readAheadSamples, horizonSamples;
+    std::atomic<juce::int64> songStart { 0 }, songEnd { 0 }, sourceOffset { 0 };
+    std::atomic<int> readTimeout { 0 };
+    bool beingServed = false; ///< Guarded by the pool's lock.
+    BlockWindow served; ///< The workers' copy of the published window; only touched while being served or under the pool's lock.
+    bool hasRetiredWindows = false; ///< Like served; a window the audio thread was reading is still to be deleted.
+    SnapshotPublisher<BlockWindow> window; ///< Published by the workers, read by readSamples().
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ReadAheadReader)
 };
 
 class PossiblyBufferedReader
@@ -30,7 +121,7 @@ class PossiblyBufferedReader
 public:
     PossiblyBufferedReader() = default;
 
-    explicit PossiblyBufferedReader (std::unique_ptr<juce::BufferingAudioReader> readerIn)
+    explicit PossiblyBufferedReader (std::unique_ptr<ReadAheadReader> readerIn)
         : setTimeoutFn ([ptr = readerIn.get()] (int ms) { ptr->setReadTimeout (ms); }),
           reader (std::move (readerIn))
     {}
@@ -52,11 +143,13 @@ private:
     std::unique_ptr<juce::AudioFormatReader> reader;
 };
 
-class AmnesiaDemoPlaybackRenderer  : public juce::ARAPlaybackRenderer
+class AmnesiaDemoPlaybackRenderer  : public juce::ARAPlaybackRenderer,
+                                     private juce::ARADocument::Listener
 {
 public:
     //==============================================================================
     using juce::ARAPlaybackRenderer::ARAPlaybackRenderer;
+    ~AmnesiaDemoPlaybackRenderer() override;
 
     //==============================================================================
     void prepareToPlay (double sampleRate,
@@ -71,15 +164,110 @@ public:
                        juce::AudioProcessor::Realtime realtime,
                        const juce::AudioPlayHead::PositionInfo& positionInfo) noexcept override;
 
+    /** Sections and base delay for the next processBlock(), which places them on its own song time;
+        set from the processor's audio callback. */
+    void setSectionedDelayContext (const SectionedDelayContext& context) { sectionContext = context; }
+    /** Audio thread only, between blocks. */
+    double getDelayTailLengthSeconds() const;
+
 private:
+    static constexpr int offlineChunkSize = 16384; ///< Offline renders read ahead in chunks of this many samples.
+    static constexpr double readAheadHorizonSeconds = 10.0; ///< Regions further from the playhead aren't read ahead.
+    static constexpr juce::int64 readAheadWakeUpInterval = AudioSourceBlockCache::blockSize / 4; ///< Playhead movement that wakes the read-ahead.
+
+    struct SequenceRender;
+
+    /** One region's samples for the current block, in song-time buffer positions. */
+    struct RegionRender
+    {
+        juce::ARAPlaybackRegion* playbackRegion = nullptr;
+        SequenceRender* sequence = nullptr;
+        size_t sourceIndex = 0; ///< Regions of one audio source share a reader, so offline they are read by one job.
+        PossiblyBufferedReader reader; ///< Realtime only; offline, regions share their source's reader.
+        ReadAheadReader* readAhead = nullptr; ///< The one in reader, for placing it on the timeline.
+        juce::Range<int> rendered; ///< Part of the block the region covers; empty if none.
+    };
+
+    /** A region sequence: its regions are summed and run through its own delay. */
+    struct SequenceRender
+    {
+        juce::AudioBuffer<float> buffer;
+        std::unique_ptr<AlphaSectionDelayPool<float>> delay; ///< Own feedback and tails per sequence.
+        bool success = true;
+        std::mutex mixLock; ///< Offline: source jobs add their regions into buffer under this.
+    };
+
+    /** A region's song-time extent with everything needed to read it worked out ahead of time. */
+    struct IndexedRegion
+    {
+        juce::Range<juce::int64> songRange; ///< Song samples the region plays.
+        juce::int64 sourceOffset; ///< Source sample = song sample + sourceOffset.
+        RegionRender* region;
+        PossiblyBufferedReader* reader; ///< nullptr if the source has none.
+    };
+
+    /** Regions sorted by start and read as an implicit balanced search tree: the middle of every
+        stretch is the root of its halves. Each node also holds the latest end in its subtree, so a
+        lookup skips whole subtrees that end before the block, and one long early region no longer
+        makes every block walk back over all the regions after it. */
+    struct RegionIndex
+    {
+        std::vector<IndexedRegion> regions;
+        std::vector<juce::int64> subtreeMaxEnds; ///< For the node at i: latest end in its subtree.
+
+        /** Call once the regions are sorted. */
+        void buildTree()
+        {
+            subtreeMaxEnds.resize (regions.size());
+            buildSubtree (0, regions.size());
+        }
+
+        void findIntersecting (juce::Range<juce::int64> range, std::vector<const IndexedRegion*>& hits) const;
+
+    private:
+        juce::int64 buildSubtree (size_t begin, size_t end);
+        void findIntersecting (juce::Range<juce::int64> range, std::vector<const IndexedRegion*>& hits, size_t begin, size_t end) const;
+    };
+
+    std::unique_ptr<RegionIndex> createRegionIndex();
+    void didEndEditing (juce::ARADocument*) override;
+
+    bool renderBlock (juce::AudioBuffer<float>& buffer, juce::int64 timeInSamples,
+                      juce::AudioProcessor::Realtime realtime, bool isPlaying);
+    bool renderFromStaging (juce::AudioBuffer<float>& buffer, juce::int64 timeInSamples);
+    /** Sums each sequence's regions into the start of its buffer. */
+    void readSequences (juce::Range<juce::int64> blockRange, juce::AudioProcessor::Realtime realtime, bool isPlaying);
+    /** Runs every sequence's delay over its buffer from startInSequences and sums them into buffer. */
+    bool runSequenceDelays (juce::AudioBuffer<float>& buffer, int startInSequences, const SectionedDelayContext& context);
+    bool readRegion (const IndexedRegion& indexed, juce::AudioBuffer<float>& destination,
+                     juce::Range<juce::int64> blockRange, juce::AudioProcessor::Realtime realtime);
+    void readSequenceSerially (SequenceRender& sequence, juce::Range<juce::int64> blockRange,
+                               juce::AudioProcessor::Realtime realtime);
+    void readInParallel (juce::Range<juce::int64> blockRange);
+    void runInParallel (int numJobs, const std::function<void (int)>& job);
+
     //==============================================================================
-    juce::SharedResourcePointer<SharedTimeSliceThread> sharedTimesliceThread;
-    std::map<juce::ARAAudioSource*, PossiblyBufferedReader> audioSourceReaders;
+    juce::SharedResourcePointer<ReadAheadPool> readAheadPool;
+    std::atomic<juce::int64> playheadSample { 0 }; ///< Song position the read-ahead works from.
+    juce::int64 lastWakeUpPlayhead = -readAheadWakeUpInterval; ///< Audio thread only.
+    std::map<juce::ARAAudioSource*, PossiblyBufferedReader> audioSourceReaders; ///< Offline renders only.
     bool useBufferedAudioSourceReader = true;
     int numChannels = 2;
     double sampleRate = 48000.0;
     int maximumSamplesPerBlock = 128;
+    int internalBlockSize = 128; ///< Largest block rendered in one go; bigger host blocks are split.
     std::unique_ptr<juce::AudioBuffer<float>> tempBuffer;
+    std::vector<std::unique_ptr<RegionRender>> regionRenders;
+    std::map<const juce::ARARegionSequence*, SequenceRender> sequenceRenders;
+    SnapshotPublisher<RegionIndex> regionIndex; ///< Rebuilt when the document changes, read by processBlock.
+    std::vector<const IndexedRegion*> hits; ///< The current block's regions; reserved for all of them.
+    std::vector<size_t> sourceJobStarts; ///< Offline: where each source's run of hits begins.
+    std::vector<juce::AudioBuffer<float>> sourceJobBuffers; ///< Offline: one scratch buffer per source job.
+    juce::ARADocument* listenedDocument = nullptr;
+    std::unique_ptr<juce::ThreadPool> renderThreads; ///< Offline renders only.
+    std::vector<SequenceRender*> sequenceJobs; ///< Offline: one delay job per sequence.
+    juce::Range<juce::int64> stagedRange; ///< Offline: song samples whose regions the sequence buffers hold.
+    SectionedDelayContext sectionContext;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AmnesiaDemoPlaybackRenderer)
 };
@@ -8,6 +8,7 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "PluginARAPlaybackRenderer.h"
 #include "CodebaseAlphaFx.h"
 
 //==============================================================================
@@ -17,22 +18,57 @@ AmnesiaDemoAudioProcessor::AmnesiaDemoAudioProcessor()
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                        ),
-    apvts (*this, nullptr),
-    m_numParams(4),
-    m_delay(0.0f),
-    m_feedback(0.0f),
-    m_mix(50.0f),
-    m_bypass(false)
+    apvts (*this, nullptr, "parent", createParameterLayout())
 #endif
 {
-    apvts.state = ValueTree("parent");
+    delayParameter = apvts.getRawParameterValue ("delay");
+    feedbackParameter = apvts.getRawParameterValue ("feedback");
+    mixParameter = apvts.getRawParameterValue ("mix");
+    bypassParameter = apvts.getRawParameterValue ("bypass");
+    baseParameterObjects = { apvts.getParameter ("delay"), apvts.getParameter ("feedback"),
+                             apvts.getParameter ("mix"), apvts.getParameter ("bypass") };
+
+    for (auto* parameter : baseParameterObjects)
+        parameter->addListener (this);
+
+    loadBaseParameters();
 
     if(!apvts.state.getChildWithName("sections").isValid())
         apvts.state.appendChild(ValueTree("sections"), nullptr);
+
+    // The section table follows the editor's edits and restored state
+    apvts.state.addListener (this);
+    rebuildSectionSpans();
 }
 
 AmnesiaDemoAudioProcessor::~AmnesiaDemoAudioProcessor()
 {
+    for (auto* parameter : baseParameterObjects)
+        parameter->removeListener (this);
+
+    apvts.state.removeListener (this);
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout AmnesiaDemoAudioProcessor::createParameterLayout()
+{
+    // These set the delay outside every section; a mix of 0 keeps it dry there
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+
+    layout.add (std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { "delay", 1 }, "Delay",
+                                                             juce::NormalisableRange<float> (0.01f, 2.0f, 0.0f, 0.5f), 0.5f,
+                                                             juce::AudioParameterFloatAttributes().withLabel ("s")));
+    layout.add (std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { "feedback", 1 }, "Feedback",
+                                                             juce::NormalisableRange<float> (0.0f, 0.98f), 0.0f));
+    layout.add (std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { "mix", 1 }, "Mix",
+                                                             juce::NormalisableRange<float> (0.0f, 1.0f), 0.0f));
+    layout.add (std::make_unique<juce::AudioParameterBool> (juce::ParameterID { "bypass", 1 }, "Bypass", false));
+
+    return layout;
+}
+
+juce::AudioProcessorParameter* AmnesiaDemoAudioProcessor::getBypassParameter() const
+{
+    return apvts.getParameter ("bypass");
 }
 
 //==============================================================================
@@ -70,11 +106,14 @@ bool AmnesiaDemoAudioProcessor::isMidiEffect() const
 
 double AmnesiaDemoAudioProcessor::getTailLengthSeconds() const
 {
+    // The delay rings on after whatever the ARA renderer plays; the audio thread keeps this current
+    const double delayTail = delayTailSeconds.load();
+
     double tail;
     if (getTailLengthSecondsForARA (tail))
-        return tail;
+        return tail + delayTail;
 
-    return 0.0;
+    return delayTail;
 }
 
 int AmnesiaDemoAudioProcessor::getNumPrograms()
@@ -104,12 +143,25 @@ void AmnesiaDemoAudioProcessor::changeProgramName (int index, const juce::String
 //==============================================================================
 void AmnesiaDemoAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    delay.reset(sampleRate);
-    auto params = delay.getParameters();
-    params.delay = m_delay;
-    params.feedback = m_feedback;
-    params.wetDryMix = m_mix;
-    delay.setParameters(params);
+    // Only the pool for the host's precision needs its engines; the first block picks up the section
+    if (getProcessingPrecision() == doublePrecision)
+    {
+        doubleDelayPool.prepare(sampleRate);
+        araFloatBuffer.setSize (getMainBusNumOutputChannels(), samplesPerBlock);
+    }
+    else
+    {
+        delayPool.prepare(sampleRate);
+        araFloatBuffer.setSize (0, 0);
+    }
+
+    // Whatever is still queued is in the atomics already
+    for (ParameterEvent event; parameterEvents.pop (event);) {}
+
+    parameterEvents.takeOverflow();
+    loadBaseParameters();
+    lastBlockStartTicks = 0;
+
     playHeadState.update (juce::nullopt);
     prepareToPlayForARA (sampleRate, samplesPerBlock, getMainBusNumOutputChannels(), getProcessingPrecision());
 }
@@ -153,90 +205,341 @@ void AmnesiaDemoAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     ignoreUnused (midiMessages);
     
     auto* audioPlayHead = getPlayHead();
-    playHeadState.update (audioPlayHead->getPosition());
+    const auto position = audioPlayHead->getPosition();
+    playHeadState.update (position);
+    auto sectionContext = getSectionedDelayContext();
+
+    // Bound to ARA, the renderer runs a delay per region sequence while it renders
+    if (auto* renderer = getPlaybackRenderer<AmnesiaDemoPlaybackRenderer>())
+    {
+        placeOnSongTime (sectionContext, position);
+        placeParameterChanges (sectionContext, buffer.getNumSamples());
+        renderer->setSectionedDelayContext (sectionContext);
+        processBlockForARA (buffer, isRealtime(), audioPlayHead);
+        delayTailSeconds = renderer->getDelayTailLengthSeconds();
+        return;
+    }
+
+    placeOnTimeline (sectionContext, position);
+    placeParameterChanges (sectionContext, buffer.getNumSamples());
+    processDelay (buffer, delayPool, sectionContext);
+    delayTailSeconds = delayPool.getTailLengthSeconds();
+}
+
+void AmnesiaDemoAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ScopedNoDenormals noDenormals;
     
-    if (! processBlockForARA (buffer, isRealtime(), audioPlayHead))
-        processBlockBypassed (buffer, midiMessages);
+    ignoreUnused (midiMessages);
     
+    auto* audioPlayHead = getPlayHead();
+    const auto position = audioPlayHead->getPosition();
+    playHeadState.update (position);
+    auto sectionContext = getSectionedDelayContext();
+
+    // ARA playback renders in float, delay included, so that goes through a conversion;
+    // otherwise the effect runs in double
+    if (auto* renderer = getPlaybackRenderer<AmnesiaDemoPlaybackRenderer>())
+    {
+        placeOnSongTime (sectionContext, position);
+        placeParameterChanges (sectionContext, buffer.getNumSamples());
+        renderer->setSectionedDelayContext (sectionContext);
+
+        // At most the prepared block size at a time, so nothing is allocated here; each chunk is
+        // rendered at its own position
+        const auto numChannels = juce::jmin (buffer.getNumChannels(), araFloatBuffer.getNumChannels());
+        const auto maxChunkSize = araFloatBuffer.getNumSamples();
+        auto chunkPosition = position.orFallback (juce::AudioPlayHead::PositionInfo {});
+        jassert (maxChunkSize > 0);
+
+        for (int start = 0; start < buffer.getNumSamples() && maxChunkSize > 0; start += maxChunkSize)
+        {
+            const auto numInChunk = juce::jmin (maxChunkSize, buffer.getNumSamples() - start);
+            juce::AudioBuffer<float> chunk (araFloatBuffer.getArrayOfWritePointers(), numChannels, numInChunk);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                convertSamples (buffer.getReadPointer (channel, start), chunk.getWritePointer (channel), numInChunk);
+
+            if (processBlockForARA (chunk, isRealtime(), chunkPosition))
+                for (int channel = 0; channel < numChannels; ++channel)
+                    convertSamples (chunk.getReadPointer (channel), buffer.getWritePointer (channel, start), numInChunk);
+
+            advancePosition (chunkPosition, numInChunk, getSampleRate());
+        }
+
+        delayTailSeconds = renderer->getDelayTailLengthSeconds();
+        return;
+    }
+
+    placeOnTimeline (sectionContext, position);
+    placeParameterChanges (sectionContext, buffer.getNumSamples());
+    processDelay (buffer, doubleDelayPool, sectionContext);
+    delayTailSeconds = doubleDelayPool.getTailLengthSeconds();
+}
+
+bool AmnesiaDemoAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+template <typename SampleType>
+void AmnesiaDemoAudioProcessor::processDelay (juce::AudioBuffer<SampleType>& buffer, AlphaSectionDelayPool<SampleType>& poolToUse,
+                                              const SectionedDelayContext& context)
+{
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
     
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
     
-    auto* leftChannelData = buffer.getWritePointer (0);
-    auto* rightChannelData = buffer.getWritePointer(1);
-    
-    for (int i = 0; i < buffer.getNumSamples(); i++)
+    // Process the block in place; the processors take planar channel pointers
+    const auto numChannels = (uint32_t) juce::jmin (totalNumInputChannels, totalNumOutputChannels, buffer.getNumChannels());
+
+    processSectionedDelay (poolToUse, buffer.getArrayOfWritePointers(), numChannels, buffer.getNumSamples(), context);
+}
+
+SectionedDelayContext AmnesiaDemoAudioProcessor::getSectionedDelayContext()
+{
+    // The base parameters as the last block left them; placeParameterChanges() adds this block's
+    SectionedDelayContext context;
+    context.spans = sectionSpans.acquire();
+    context.baseParameters = currentBaseParameters;
+    context.bypassed = currentlyBypassed;
+    context.sampleRate = getSampleRate();
+
+    return context;
+}
+
+void AmnesiaDemoAudioProcessor::placeOnSongTime (SectionedDelayContext& context, const juce::Optional<juce::AudioPlayHead::PositionInfo>& position)
+{
+    // The ARA renderer places the sections on its own song time, the same one its regions use
+    context.blockStartTime = position.hasValue() ? (double) position->getTimeInSamples().orFallback (0) / context.sampleRate : 0.0;
+}
+
+void AmnesiaDemoAudioProcessor::advancePosition (juce::AudioPlayHead::PositionInfo& position, int numSamples, double sampleRate)
+{
+    if (const auto timeInSamples = position.getTimeInSamples())
+        position.setTimeInSamples (*timeInSamples + numSamples);
+
+    if (const auto timeInSeconds = position.getTimeInSeconds())
+        position.setTimeInSeconds (*timeInSeconds + numSamples / sampleRate);
+
+    if (const auto ppqPosition = position.getPpqPosition())
+        position.setPpqPosition (*ppqPosition + numSamples / sampleRate * position.getBpm().orFallback (120.0) / 60.0);
+}
+
+template <typename Source, typename Destination>
+void AmnesiaDemoAudioProcessor::convertSamples (const Source* source, Destination* destination, int numSamples)
+{
+    for (int i = 0; i < numSamples; ++i)
+        destination[i] = (Destination) source[i];
+}
+
+void AmnesiaDemoAudioProcessor::placeParameterChanges (SectionedDelayContext& context, int numSamples)
+{
+    audioThreadId.store (juce::Thread::getCurrentThreadId(), std::memory_order_relaxed);
+
+    const auto blockStartTicks = juce::Time::getHighResolutionTicks();
+    const auto previousBlockStartTicks = lastBlockStartTicks;
+    const auto previousBlockTicks = blockStartTicks - previousBlockStartTicks;
+    const auto placeByTime = ! isNonRealtime() && previousBlockStartTicks != 0 && previousBlockTicks > 0 && numSamples > 0;
+    lastBlockStartTicks = blockStartTicks;
+
+    // A change made while the last block ran lands at the same point of this one: a block late, but
+    // as far from its neighbours as it was made. The host's automation for this block (made on the
+    // audio thread, ticks == 0) and anything older land at the start; so does everything offline,
+    // where the wall clock says nothing about the song. A parameter never goes back to before its
+    // last change, so it ends up with the value it was given last
+    struct PlacedEvent
+    {
+        int offset;
+        ParameterEvent event;
+    };
+
+    std::array<PlacedEvent, maxParameterEventsPerBlock> placed;
+    std::array<int, numBaseParameters> lastOffsets {};
+    int numPlaced = 0;
+    ParameterEvent event;
+
+    while (numPlaced < maxParameterEventsPerBlock && parameterEvents.pop (event))
     {
-        float inputFrame[2]{ leftChannelData[i], rightChannelData[i] };
-        float outputFrame[2];
-        
-        delay.processAudioFrame(inputFrame, outputFrame, totalNumInputChannels, totalNumOutputChannels);
-//        chorus.processAudioFrame(inputFrame, outputFrame, totalNumInputChannels, totalNumOutputChannels);
-        
-        buffer.setSample(0, i, outputFrame[0]);
-        buffer.setSample(1, i, outputFrame[1]);
+        juce::int64 offset = 0;
+
+        if (placeByTime && event.ticks > previousBlockStartTicks)
+            offset = juce::jmin ((juce::int64) numSamples - 1, (event.ticks - previousBlockStartTicks) * numSamples / previousBlockTicks);
+
+        auto& lastOffset = lastOffsets[(size_t) event.parameter];
+        lastOffset = juce::jmax (lastOffset, (int) offset);
+
+        // In offset order, after any already at the same sample
+        auto index = numPlaced++;
+
+        for (; index > 0 && placed[(size_t) index - 1].offset > lastOffset; --index)
+            placed[(size_t) index] = placed[(size_t) index - 1];
+
+        placed[(size_t) index] = { lastOffset, event };
+    }
+
+    auto addChange = [this, &context] (int offset)
+    {
+        // At the start the block's own base parameters change; later ones share a change per sample,
+        // and once there is no room left they all go into the last one
+        auto& changes = context.parameterChanges;
+        auto& numChanges = context.numParameterChanges;
+        const auto time = context.blockStartTime + offset / context.sampleRate;
+
+        if (offset == 0)
+        {
+            context.baseParameters = currentBaseParameters;
+            context.bypassed = currentlyBypassed;
+        }
+        else if (numChanges > 0 && (changes[(size_t) numChanges - 1].time == time || numChanges == SectionedDelayContext::kMaxParameterChanges))
+        {
+            changes[(size_t) numChanges - 1].parameters = currentBaseParameters;
+            changes[(size_t) numChanges - 1].bypassed = currentlyBypassed;
+        }
+        else
+        {
+            changes[(size_t) numChanges++] = { time, currentBaseParameters, currentlyBypassed };
+        }
+    };
+
+    for (int i = 0; i < numPlaced; ++i)
+    {
+        applyParameterEvent (placed[(size_t) i].event);
+        addChange (placed[(size_t) i].offset);
+    }
+
+    // Changes were dropped: the latest values are all that is left of them
+    if (parameterEvents.takeOverflow())
+    {
+        loadBaseParameters();
+        addChange (numPlaced > 0 ? placed[(size_t) numPlaced - 1].offset : 0);
     }
-    
 }
 
-void AmnesiaDemoAudioProcessor::processBlockBypassed (AudioSampleBuffer& buffer, MidiBuffer& /*midiMessages*/)
+void AmnesiaDemoAudioProcessor::loadBaseParameters()
 {
-    for (int channel = 0; channel < getTotalNumInputChannels(); ++channel)
+    currentBaseParameters.delay = delayParameter->load();
+    currentBaseParameters.feedback = feedbackParameter->load();
+    currentBaseParameters.wetDryMix = mixParameter->load();
+    currentlyBypassed = bypassParameter->load() >= 0.5f;
+}
+
+void AmnesiaDemoAudioProcessor::applyParameterEvent (const ParameterEvent& event)
+{
+    switch (event.parameter)
     {
-        auto data = buffer.getWritePointer(channel);
-        for (int i = 0; i < buffer.getNumSamples(); ++i)
+        case delayIndex:    currentBaseParameters.delay = event.value; break;
+        case feedbackIndex: currentBaseParameters.feedback = event.value; break;
+        case mixIndex:      currentBaseParameters.wetDryMix = event.value; break;
+        case bypassIndex:   currentlyBypassed = event.value >= 0.5f; break;
+        default:            break;
+    }
+}
+
+void AmnesiaDemoAudioProcessor::parameterValueChanged (int parameterIndex, float newValue)
+{
+    // Runs on whichever thread changed the parameter: only note the change and when it was made
+    const auto onAudioThread = juce::Thread::getCurrentThreadId() == audioThreadId.load (std::memory_order_relaxed);
+
+    for (int i = 0; i < numBaseParameters; ++i)
+    {
+        auto* parameter = baseParameterObjects[(size_t) i];
+
+        if (parameter->getParameterIndex() == parameterIndex)
         {
-            data[i] = data[i];
+            parameterEvents.push ({ i, parameter->convertFrom0to1 (newValue), onAudioThread ? 0 : juce::Time::getHighResolutionTicks() });
+            return;
         }
     }
 }
 
-float AmnesiaDemoAudioProcessor::getParameter (int param)
+void AmnesiaDemoAudioProcessor::placeOnTimeline (SectionedDelayContext& context, const juce::Optional<juce::AudioPlayHead::PositionInfo>& position)
 {
-    
-    switch (param)
+    // Without a timeline position only the base delay can play
+    if (! position.hasValue() || ! position->getTimeInSeconds().hasValue())
     {
-        case DELAY:
-            return m_delay;
-        case FEEDBACK:
-            return m_feedback;
-        case MIX:
-            return m_mix;
-        case BYPASS:
-            return m_bypass;
-        default:
-            return 0;
+        context.spans = nullptr;
+        return;
     }
+
+    context.blockStartTime = *position->getTimeInSeconds();
+    context.secondsPerBeat = 60.0 / position->getBpm().orFallback (120.0);
+}
+
+void AmnesiaDemoAudioProcessor::processBlockBypassed (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    // The host bypasses us itself: the input passes through dry, outputs without an input stay silent
+    for (auto channel = getTotalNumInputChannels(); channel < getTotalNumOutputChannels(); ++channel)
+        buffer.clear (channel, 0, buffer.getNumSamples());
+}
+
+void AmnesiaDemoAudioProcessor::processBlockBypassed (juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    for (auto channel = getTotalNumInputChannels(); channel < getTotalNumOutputChannels(); ++channel)
+        buffer.clear (channel, 0, buffer.getNumSamples());
+}
+
+bool AmnesiaDemoAudioProcessor::isSectionTree (const juce::ValueTree& tree) const
+{
+    const auto sectionTree = apvts.state.getChildWithName ("sections");
+
+    return tree == sectionTree || tree.isAChildOf (sectionTree);
 }
 
-void AmnesiaDemoAudioProcessor::setParameter (int param, float val)
+void AmnesiaDemoAudioProcessor::rebuildSectionSpans()
 {
-    auto params = delay.getParameters();
+    // Cut the timeline at every section edge; where sections overlap the first one wins, as in the editor
+    const auto sectionTree = apvts.state.getChildWithName ("sections");
 
-    switch (param)
+    std::vector<double> edges;
+
+    for (const auto& child : sectionTree)
     {
-        case DELAY:
-            m_delay = val;
-            if(params.delay != val) params.delay = val;
-            break;
-        case FEEDBACK:
-            m_feedback = val;
-            if(params.feedback != val) params.feedback = val;
-            break;
-        case MIX:
-            m_mix= val;
-            if(params.wetDryMix != val) params.wetDryMix = val;
-            break;
-        case BYPASS:
-            m_bypass = static_cast<bool>(val);
-            break;
-        default:
-            break;
+        edges.push_back (child.getProperty ("startPos"));
+        edges.push_back (child.getProperty ("endPos"));
     }
-    
-    delay.setParameters(params);
+
+    std::sort (edges.begin(), edges.end());
+    edges.erase (std::unique (edges.begin(), edges.end()), edges.end());
+
+    auto spans = std::make_unique<SectionSpans>();
+    spans->push_back ({ std::numeric_limits<double>::lowest(), -1, 0.0f, 0.0f, 0.0f });
+
+    for (size_t i = 0; i < edges.size(); ++i)
+    {
+        SectionSpan span { edges[i], -1, 0.0f, 0.0f, 0.0f };
+
+        // Nothing plays after the last edge
+        if (i + 1 < edges.size())
+        {
+            const auto middle = 0.5 * (edges[i] + edges[i + 1]);
+
+            for (int index = 0; index < sectionTree.getNumChildren(); ++index)
+            {
+                const auto child = sectionTree.getChild (index);
+
+                if ((double) child.getProperty ("startPos") <= middle && middle <= (double) child.getProperty ("endPos"))
+                {
+                    const auto delays = child.getChildWithName ("delays");
+                    span.section = index;
+                    span.beatDelay = delays.getProperty ("beatDelay", 2.0f);
+                    span.feedback = delays.getProperty ("feedback", 0.0f);
+                    span.mix = delays.getProperty ("mix", 1.0f);
+                    break;
+                }
+            }
+        }
+
+        if (span.section == spans->back().section && span.section == -1)
+            continue;
+
+        spans->push_back (span);
+    }
+
+    // The audio thread picks this up at its next block; tables it has let go of are freed here
+    sectionSpans.publish (std::move (spans));
 }
 
 //==============================================================================
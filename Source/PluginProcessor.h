@@ -19,6 +19,8 @@ class AmnesiaDemoAudioProcessor  : public juce::AudioProcessor
                             #if JucePlugin_Enable_ARA
                              , public juce::AudioProcessorARAExtension
                             #endif
+                             , private juce::ValueTree::Listener
+                             , private juce::AudioProcessorParameter::Listener
 {
 public:
     juce::AudioProcessorValueTreeState apvts;
@@ -38,10 +40,14 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
-    void processBlockBypassed (juce::AudioSampleBuffer& buffer, juce::MidiBuffer& midiMessages) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
+    void processBlockBypassed (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) override;
+    void processBlockBypassed (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages) override;
+
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+    juce::AudioProcessorParameter* getBypassParameter() const override;
 
-    float getParameter (int param) override; ///< Gets a specified parameter value.
-    void setParameter (int param, float val) override; ///< Sets a specified parameter value based on the index.
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
@@ -67,13 +73,69 @@ public:
 
 private:
     
-    int m_numParams; ///< Number of processor parameters.
-    float m_delay; ///< Delay time parameter (msecs).
-    float m_feedback; ///< Feedback parameter (%).
-    float m_mix; ///< Mix parameter (%).
-    bool m_bypass; ///< Bypass parameter (true = bypass).
-
-    AlphaSimpleDelay delay;
+    /** The parameters that make up the base delay, in the order ParameterEvent refers to them. */
+    enum BaseParameter { delayIndex, feedbackIndex, mixIndex, bypassIndex, numBaseParameters };
+
+    /** A change of a base parameter on its way to processBlock. */
+    struct ParameterEvent
+    {
+        int parameter = 0; ///< A BaseParameter.
+        float value = 0.0f; ///< Denormalised.
+        juce::int64 ticks = 0; ///< When it was made, from juce::Time::getHighResolutionTicks().
+    };
+
+    // Any thread may change a parameter (host automation, the editor, setStateInformation()). Each change
+    // is queued with the time it was made, and processBlock applies it at the matching sample of its
+    // block; if the queue ever overflows, the atomics' latest values take over instead.
+    // NOTE: JUCE's plugin wrappers hand the host's automation over once per block, before processBlock and
+    // without a sample offset, so automation is block-accurate (the delay's ramps smooth it from the block
+    // start). Only changes made from other threads, e.g. the editor, land inside a block.
+    std::atomic<float>* delayParameter = nullptr; ///< Delay time (seconds); cached from apvts for the audio thread.
+    std::atomic<float>* feedbackParameter = nullptr; ///< Feedback (0 - 1).
+    std::atomic<float>* mixParameter = nullptr; ///< Mix (0 - 1).
+    std::atomic<float>* bypassParameter = nullptr; ///< Bypass (> 0.5 = bypass).
+    std::array<juce::RangedAudioParameter*, numBaseParameters> baseParameterObjects {}; ///< Listened to for parameterEvents.
+    MultiProducerQueue<ParameterEvent, 1024> parameterEvents;
+    std::atomic<juce::Thread::ThreadID> audioThreadId { nullptr }; ///< Changes made on it are the host's automation for the next block.
+    static constexpr int maxParameterEventsPerBlock = 128; ///< The rest wait for the next block.
+
+    // Audio thread only: the base parameters as of the end of the last block, and when it started
+    AlphaSimpleDelayParameters currentBaseParameters;
+    bool currentlyBypassed = false;
+    juce::int64 lastBlockStartTicks = 0;
+
+    AlphaSectionDelayPool<float> delayPool;
+    AlphaSectionDelayPool<double> doubleDelayPool; ///< used instead of delayPool when the host processes in double precision
+    juce::AudioBuffer<float> araFloatBuffer; ///< the ARA renderer only renders float; double blocks go through this, a chunk at a time
+    std::atomic<double> delayTailSeconds { 0.0 }; ///< Written by processBlock, read by getTailLengthSeconds() on any thread.
+
+    SnapshotPublisher<SectionSpans> sectionSpans; ///< Rebuilt by whichever thread changes the sections, read by processBlock.
+
+    void rebuildSectionSpans();
+    bool isSectionTree (const juce::ValueTree& tree) const;
+    SectionedDelayContext getSectionedDelayContext();
+    static void placeOnTimeline (SectionedDelayContext& context, const juce::Optional<juce::AudioPlayHead::PositionInfo>& position);
+    static void placeOnSongTime (SectionedDelayContext& context, const juce::Optional<juce::AudioPlayHead::PositionInfo>& position);
+    static void advancePosition (juce::AudioPlayHead::PositionInfo& position, int numSamples, double sampleRate);
+    template <typename Source, typename Destination>
+    static void convertSamples (const Source* source, Destination* destination, int numSamples);
+    void placeParameterChanges (SectionedDelayContext& context, int numSamples);
+    void loadBaseParameters();
+    void applyParameterEvent (const ParameterEvent& event);
+
+    void parameterValueChanged (int parameterIndex, float newValue) override;
+    void parameterGestureChanged (int, bool) override {}
+
+    // Parameters live in the same tree; only edits under "sections" rebuild the table
+    void valueTreePropertyChanged (juce::ValueTree& tree, const juce::Identifier&) override { if (isSectionTree (tree)) rebuildSectionSpans(); }
+    void valueTreeChildAdded (juce::ValueTree& parent, juce::ValueTree&) override { if (isSectionTree (parent)) rebuildSectionSpans(); }
+    void valueTreeChildRemoved (juce::ValueTree& parent, juce::ValueTree&, int) override { if (isSectionTree (parent)) rebuildSectionSpans(); }
+    void valueTreeChildOrderChanged (juce::ValueTree& parent, int, int) override { if (isSectionTree (parent)) rebuildSectionSpans(); }
+    void valueTreeRedirected (juce::ValueTree&) override { rebuildSectionSpans(); }
+
+    template <typename SampleType>
+    void processDelay (juce::AudioBuffer<SampleType>& buffer, AlphaSectionDelayPool<SampleType>& poolToUse,
+                       const SectionedDelayContext& context);
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AmnesiaDemoAudioProcessor)
@@ -9,3 +9,230 @@
 */
 
 #include "Utilities.h"
+
+//==============================================================================
+AudioSourceBlockCache::AudioSourceBlockCache (size_t memoryBudgetBytes)
+    : memoryBudget (memoryBudgetBytes)
+{
+}
+
+AudioSourceBlockCache::~AudioSourceBlockCache()
+{
+    for (const auto& entry : sources)
+        entry.first->removeListener (this);
+}
+
+void AudioSourceBlockCache::addAudioSource (juce::ARAAudioSource* audioSource)
+{
+    const std::lock_guard<std::mutex> guard (lock);
+    auto& source = sources[audioSource];
+
+    if (source == nullptr)
+        audioSource->addListener (this);
+
+    // A reader invalidated by a change of the samples is replaced here, on the message thread
+    if (source == nullptr || ! source->reader.isValid())
+        source = std::make_shared<Source> (audioSource);
+}
+
+std::unique_ptr<juce::AudioFormatReader> AudioSourceBlockCache::createReader (juce::ARAAudioSource* audioSource)
+{
+    addAudioSource (audioSource);
+    return std::make_unique<CachedAudioSourceReader> (*this, audioSource);
+}
+
+bool AudioSourceBlockCache::read (juce::ARAAudioSource* audioSource, float* const* dest, int numDestChannels,
+                                  int startOffsetInDest, juce::int64 startSample, int numSamples, bool fetchMissing)
+{
+    // Only the registry is consulted here: the source itself may already be gone
+    const auto source = findSource (audioSource);
+    const auto sampleCount = source != nullptr ? source->sampleCount : 0;
+    auto success = source != nullptr;
+
+    while (numSamples > 0)
+    {
+        const auto blockIndex = (startSample >= 0 ? startSample : startSample - blockSize + 1) / blockSize;
+        const auto offsetInBlock = (int) (startSample - blockIndex * blockSize);
+        const auto numInBlock = juce::jmin (numSamples, blockSize - offsetInBlock);
+
+        std::shared_ptr<const Block> block;
+
+        if (source != nullptr && startSample >= 0 && startSample < sampleCount)
+        {
+            block = getBlock (source, { audioSource, blockIndex }, fetchMissing);
+            success = success && block != nullptr;
+        }
+
+        for (int channel = 0; channel < numDestChannels; ++channel)
+        {
+            if (dest[channel] == nullptr)
+                continue;
+
+            // The part of a block past the end of the source is stored as silence
+            if (block != nullptr && channel < block->getNumChannels())
+                juce::FloatVectorOperations::copy (dest[channel] + startOffsetInDest,
+                                                   block->getReadPointer (channel, offsetInBlock), numInBlock);
+            else
+                juce::FloatVectorOperations::clear (dest[channel] + startOffsetInDest, numInBlock);
+        }
+
+        startOffsetInDest += numInBlock;
+        startSample += numInBlock;
+        numSamples -= numInBlock;
+    }
+
+    return success;
+}
+
+std::shared_ptr<const AudioSourceBlockCache::Block> AudioSourceBlockCache::fetchBlock (juce::ARAAudioSource* audioSource, juce::int64 blockIndex)
+{
+    const auto source = findSource (audioSource);
+
+    if (source == nullptr || blockIndex < 0 || blockIndex * blockSize >= source->sampleCount)
+        return {};
+
+    return getBlock (source, { audioSource, blockIndex }, true);
+}
+
+size_t AudioSourceBlockCache::getMemoryUsage() const
+{
+    const std::lock_guard<std::mutex> guard (lock);
+    return memoryUsage;
+}
+
+std::shared_ptr<AudioSourceBlockCache::Source> AudioSourceBlockCache::findSource (juce::ARAAudioSource* audioSource) const
+{
+    const std::lock_guard<std::mutex> guard (lock);
+    const auto iter = sources.find (audioSource);
+    return iter != sources.end() ? iter->second : nullptr;
+}
+
+std::shared_ptr<const AudioSourceBlockCache::Block> AudioSourceBlockCache::getBlock (const std::shared_ptr<Source>& source, const BlockKey& key, bool fetchMissing)
+{
+    {
+        const std::lock_guard<std::mutex> guard (lock);
+
+        if (auto block = findBlock (key))
+            return block;
+    }
+
+    if (! fetchMissing)
+        return {};
+
+    const std::lock_guard<std::mutex> fetchGuard (source->fetchLock);
+    juce::uint32 generation = 0;
+
+    // Another thread may have fetched the block while this one waited
+    {
+        const std::lock_guard<std::mutex> guard (lock);
+
+        if (auto block = findBlock (key))
+            return block;
+
+        generation = source->generation;
+    }
+
+    const auto startSample = key.second * blockSize;
+    const auto numSamples = (int) juce::jmin ((juce::int64) blockSize, source->sampleCount - startSample);
+
+    auto block = std::make_shared<Block> ((int) source->reader.numChannels, blockSize);
+    block->clear();
+
+    if (! source->reader.read (block.get(), 0, numSamples, startSample, true, true))
+        return {};
+
+    const std::lock_guard<std::mutex> guard (lock);
+
+    // Samples of a source that was replaced, destroyed or changed meanwhile are not worth keeping
+    const auto iter = sources.find (key.first);
+
+    if (iter == sources.end() || iter->second != source || ! source->reader.isValid() || source->generation != generation)
+        return block;
+
+    insertBlock (key, block);
+    return block;
+}
+
+std::shared_ptr<const AudioSourceBlockCache::Block> AudioSourceBlockCache::findBlock (const BlockKey& key)
+{
+    const auto iter = blocks.find (key);
+
+    if (iter == blocks.end())
+        return {};
+
+    leastRecentlyUsed.splice (leastRecentlyUsed.begin(), leastRecentlyUsed, iter->second.lruPosition);
+    return iter->second.block;
+}
+
+void AudioSourceBlockCache::insertBlock (const BlockKey& key, std::shared_ptr<const Block> block)
+{
+    leastRecentlyUsed.push_front (key);
+    memoryUsage += (size_t) block->getNumChannels() * blockSize * sizeof (float);
+    blocks.emplace (key, Entry { std::move (block), leastRecentlyUsed.begin() });
+
+    // Blocks still being copied out stay alive through their shared_ptr
+    while (memoryUsage > memoryBudget && leastRecentlyUsed.size() > 1)
+    {
+        const auto iter = blocks.find (leastRecentlyUsed.back());
+        memoryUsage -= (size_t) iter->second.block->getNumChannels() * blockSize * sizeof (float);
+        blocks.erase (iter);
+        leastRecentlyUsed.pop_back();
+    }
+}
+
+void AudioSourceBlockCache::removeBlocks (juce::ARAAudioSource* audioSource)
+{
+    auto iter = blocks.lower_bound ({ audioSource, std::numeric_limits<juce::int64>::min() });
+
+    while (iter != blocks.end() && iter->first.first == audioSource)
+    {
+        memoryUsage -= (size_t) iter->second.block->getNumChannels() * blockSize * sizeof (float);
+        leastRecentlyUsed.erase (iter->second.lruPosition);
+        iter = blocks.erase (iter);
+    }
+}
+
+void AudioSourceBlockCache::doUpdateAudioSourceContent (juce::ARAAudioSource* audioSource, juce::ARAContentUpdateScopes scopeFlags)
+{
+    if (! scopeFlags.affectSamples())
+        return;
+
+    const std::lock_guard<std::mutex> guard (lock);
+
+    // A host read already under way returns the old samples; the new generation keeps them out
+    if (const auto iter = sources.find (audioSource); iter != sources.end())
+        ++iter->second->generation;
+
+    removeBlocks (audioSource);
+    ++contentGeneration;
+}
+
+void AudioSourceBlockCache::willDestroyAudioSource (juce::ARAAudioSource* audioSource)
+{
+    audioSource->removeListener (this);
+
+    const std::lock_guard<std::mutex> guard (lock);
+    removeBlocks (audioSource);
+    sources.erase (audioSource);
+    ++contentGeneration;
+}
+
+//==============================================================================
+CachedAudioSourceReader::CachedAudioSourceReader (AudioSourceBlockCache& cacheIn, juce::ARAAudioSource* audioSourceIn)
+    : AudioFormatReader (nullptr, "CachedAudioSourceReader"),
+      cache (cacheIn),
+      audioSource (audioSourceIn)
+{
+    bitsPerSample = 32;
+    usesFloatingPointData = true;
+    sampleRate = audioSource->getSampleRate();
+    numChannels = (unsigned int) audioSource->getChannelCount();
+    lengthInSamples = audioSource->getSampleCount();
+}
+
+bool CachedAudioSourceReader::readSamples (int* const* destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                                           juce::int64 startSampleInFile, int numSamples)
+{
+    return cache.read (audioSource, reinterpret_cast<float* const*> (destSamples), numDestChannels,
+                       startOffsetInDestBuffer, startSampleInFile, numSamples);
+}
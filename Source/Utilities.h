@@ -10,7 +10,12 @@
 
 #pragma once
 #include<string>
+#include <array>
+#include <list>
+#include <map>
+#include <mutex>
 #include <JuceHeader.h>
+#include "CodebaseAlphaFx.h"
 
 class TimeToViewScaling
 {
@@ -90,6 +95,315 @@ struct PlayHeadState
                         loopPpqEnd    { 0.0 };
 };
 
+//==============================================================================
+/** Hands immutable snapshots from any number of publishing threads to one realtime reader.
+
+    The publisher swaps a new snapshot in with an atomic exchange. The reader announces the snapshot
+    it is using in a single reader slot (a hazard pointer) and keeps it until its next acquire().
+    Retired snapshots are deleted by a publisher, once the reader no longer holds them, so the reader
+    never waits, allocates or frees. Publishers (e.g. listener callbacks, setStateInformation() and
+    prepareToPlay()) are serialised by a lock that the reader never takes.
+*/
+template <typename Snapshot>
+class SnapshotPublisher
+{
+public:
+    SnapshotPublisher() = default;
+
+    ~SnapshotPublisher()
+    {
+        delete latest.load();
+
+        for (auto* snapshot : retired)
+            delete snapshot;
+    }
+
+    /** Any thread but the reader's; may block on another publisher. */
+    void publish (std::unique_ptr<Snapshot> snapshot)
+    {
+        const std::lock_guard<std::mutex> guard (publishLock);
+
+        if (auto* previous = latest.exchange (snapshot.release()))
+            retired.push_back (previous);
+
+        collectRetired();
+    }
+
+    /** Any thread but the reader's; deletes every retired snapshot the reader has moved past.
+        Returns true if none is left. */
+    bool collectGarbage()
+    {
+        const std::lock_guard<std::mutex> guard (publishLock);
+        collectRetired();
+        return retired.empty();
+    }
+
+    /** Reader thread only: the latest snapshot (or nullptr before the first publish), valid until
+        the next call or release(). Wait-free in practice: it retries only if a publish lands in between. */
+    const Snapshot* acquire() noexcept
+    {
+        Snapshot* snapshot = latest.load();
+
+        for (;;)
+        {
+            readerSlot.store (snapshot);
+
+            auto* check = latest.load();
+
+            if (check == snapshot)
+                return snapshot;
+
+            snapshot = check;
+        }
+    }
+
+    /** Reader thread only: done with the snapshot from acquire(), so a publisher may free it
+        without waiting for the next acquire(). */
+    void release() noexcept
+    {
+        readerSlot.store (nullptr);
+    }
+
+private:
+    std::atomic<Snapshot*> latest { nullptr };
+    std::atomic<const Snapshot*> readerSlot { nullptr };
+    std::mutex publishLock; ///< Serialises publishers; never taken by the reader.
+    std::vector<Snapshot*> retired; ///< Guarded by publishLock.
+
+    void collectRetired()
+    {
+        const auto* inUse = readerSlot.load();
+
+        retired.erase (std::remove_if (retired.begin(), retired.end(), [inUse] (Snapshot* snapshot)
+                                       {
+                                           if (snapshot == inUse)
+                                               return false;
+
+                                           delete snapshot;
+                                           return true;
+                                       }),
+                       retired.end());
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (SnapshotPublisher)
+};
+
+//==============================================================================
+/** Hands events from any number of threads to one realtime consumer, in the order they were pushed.
+
+    A bounded ring of cells, each with a sequence number: a producer claims a cell by advancing the
+    write position with a compare-and-swap and publishes it through the cell's sequence, and the
+    consumer hands the cell back the same way. Nobody locks, allocates or frees. A full queue drops
+    the event and remembers that it did, so the consumer can fall back on the latest state instead.
+*/
+template <typename Event, size_t capacity>
+class MultiProducerQueue
+{
+public:
+    static_assert (capacity > 0 && (capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+
+    MultiProducerQueue()
+    {
+        for (size_t i = 0; i < capacity; ++i)
+            cells[i].sequence.store (i, std::memory_order_relaxed);
+    }
+
+    /** Any thread; lock-free. False if the queue was full and the event was dropped. */
+    bool push (const Event& event) noexcept
+    {
+        auto position = writePosition.load (std::memory_order_relaxed);
+
+        for (;;)
+        {
+            auto& cell = cells[position & (capacity - 1)];
+            const auto sequence = cell.sequence.load (std::memory_order_acquire);
+
+            if (sequence == position)
+            {
+                if (writePosition.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
+                {
+                    cell.event = event;
+                    cell.sequence.store (position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (sequence < position)
+            {
+                overflowed.store (true, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                position = writePosition.load (std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /** Consumer thread only; wait-free. False if no event is ready (one still being pushed waits
+        for the next call, and so do the ones after it). */
+    bool pop (Event& event) noexcept
+    {
+        auto& cell = cells[readPosition & (capacity - 1)];
+
+        if (cell.sequence.load (std::memory_order_acquire) != readPosition + 1)
+            return false;
+
+        event = cell.event;
+        cell.sequence.store (readPosition + capacity, std::memory_order_release);
+        ++readPosition;
+        return true;
+    }
+
+    /** Consumer thread only: true once after any push() found the queue full. */
+    bool takeOverflow() noexcept
+    {
+        return overflowed.exchange (false, std::memory_order_relaxed);
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence { 0 };
+        Event event {};
+    };
+
+    std::array<Cell, capacity> cells;
+    std::atomic<size_t> writePosition { 0 };
+    size_t readPosition = 0; ///< Consumer only.
+    std::atomic<bool> overflowed { false };
+
+    JUCE_DECLARE_NON_COPYABLE (MultiProducerQueue)
+};
+
+//==============================================================================
+/** A stretch of the timeline over which one section plays (or none, section == -1). */
+struct SectionSpan
+{
+    double startTime; ///< Seconds; the span lasts until the next one starts.
+    int section;
+    float beatDelay;
+    float feedback;
+    float mix;
+};
+
+using SectionSpans = std::vector<SectionSpan>; ///< Sorted; the first span starts at -infinity.
+
+/** New base parameters from a point on the timeline on, e.g. an editor change that landed mid-block. */
+struct BaseParameterChange
+{
+    double time; ///< Same timeline as SectionedDelayContext::blockStartTime.
+    AlphaSimpleDelayParameters parameters;
+    bool bypassed;
+};
+
+/** Everything the sectioned delay needs for a block besides the audio. */
+struct SectionedDelayContext
+{
+    static constexpr int kBaseSection = -2; ///< Pool id of the base delay.
+    static constexpr int kMaxParameterChanges = 32; ///< Per host block; later ones merge into the last.
+
+    const SectionSpans* spans = nullptr; ///< nullptr without a timeline position: only the base delay plays.
+    double blockStartTime = 0.0; ///< Timeline seconds of the block's first sample.
+    double secondsPerBeat = 0.5;
+    double sampleRate = 44100.0;
+    AlphaSimpleDelayParameters baseParameters; ///< Plays wherever no section does, until the first change.
+    bool bypassed = false;
+    std::array<BaseParameterChange, kMaxParameterChanges> parameterChanges; ///< In time order.
+    int numParameterChanges = 0;
+};
+
+/** Runs a block through a section pool, switching sections at the exact sample they start and
+    taking up base parameter changes at the sample they land on. One lookup per block, then the
+    block is split at every section boundary and parameter change inside it. */
+template <typename SampleType>
+void processSectionedDelay (AlphaSectionDelayPool<SampleType>& pool, SampleType* const* channels,
+                            uint32_t numChannels, int numSamples, const SectionedDelayContext& context)
+{
+    if (numChannels == 0 || numSamples == 0)
+        return;
+
+    auto getSampleForTime = [&] (double time)
+    {
+        return (int) juce::jlimit (0.0, (double) numSamples, std::ceil ((time - context.blockStartTime) * context.sampleRate));
+    };
+
+    // Changes are placed on whole samples, so round rather than take the next one
+    auto getSampleForChange = [&] (const BaseParameterChange& change)
+    {
+        return (int) juce::jlimit (0.0, (double) numSamples, std::round ((change.time - context.blockStartTime) * context.sampleRate));
+    };
+
+    const auto* baseParameters = &context.baseParameters;
+    auto bypassed = context.bypassed;
+    const auto* change = context.parameterChanges.data();
+    const auto* changesEnd = change + context.numParameterChanges;
+
+    const SectionSpan* span = nullptr;
+    const SectionSpan* spansEnd = nullptr;
+
+    if (context.spans != nullptr && ! context.spans->empty())
+    {
+        span = &*std::prev (std::upper_bound (context.spans->begin(), context.spans->end(), context.blockStartTime,
+                                              [] (double time, const SectionSpan& s) { return time < s.startTime; }));
+        spansEnd = context.spans->data() + context.spans->size();
+    }
+
+    for (int startSample = 0; startSample < numSamples;)
+    {
+        auto endSample = numSamples;
+
+        for (; change != changesEnd && getSampleForChange (*change) <= startSample; ++change)
+        {
+            baseParameters = &change->parameters;
+            bypassed = change->bypassed;
+        }
+
+        if (change != changesEnd)
+            endSample = getSampleForChange (*change);
+
+        // Bypassed: every section fades out to dry and the tails ring out
+        if (bypassed)
+        {
+            SampleType* segment[2] = { channels[0] + startSample, channels[numChannels - 1] + startSample };
+            pool.setSection (AlphaSectionDelayPool<SampleType>::kNoSection, *baseParameters);
+            pool.processAudioBlock (segment, juce::jmin (numChannels, 2u), (uint32_t) (endSample - startSample));
+
+            startSample = endSample;
+            continue;
+        }
+
+        if (span != nullptr)
+        {
+            while (span + 1 != spansEnd && getSampleForTime (span[1].startTime) <= startSample)
+                ++span;
+
+            if (span + 1 != spansEnd)
+                endSample = juce::jmin (endSample, getSampleForTime (span[1].startTime));
+        }
+
+        if (span != nullptr && span->section >= 0)
+        {
+            AlphaSimpleDelayParameters params;
+            params.delay = span->beatDelay * context.secondsPerBeat;
+            params.feedback = span->feedback;
+            params.wetDryMix = span->mix;
+            pool.setSection (span->section, params);
+        }
+        else
+        {
+            // A silent base delay does not need an engine
+            pool.setSection (baseParameters->wetDryMix > 0.0 ? SectionedDelayContext::kBaseSection
+                                                             : AlphaSectionDelayPool<SampleType>::kNoSection,
+                             *baseParameters);
+        }
+
+        SampleType* segment[2] = { channels[0] + startSample, channels[numChannels - 1] + startSample };
+        pool.processAudioBlock (segment, juce::jmin (numChannels, 2u), (uint32_t) (endSample - startSample));
+
+        startSample = endSample;
+    }
+}
+
 //==============================================================================
 struct PreviewState
 {
@@ -97,5 +411,103 @@ struct PreviewState
     std::atomic<juce::ARAPlaybackRegion*> previewedRegion { nullptr };
 };
 
-enum Param { DELAY, FEEDBACK, MIX, BYPASS };
+//==============================================================================
+/** Decoded samples of a document's audio sources, shared by everything that reads them.
+
+    Samples are fetched from the host in fixed-size blocks, keyed by audio source and block index,
+    and kept in least-recently-used order under a memory budget. Playback, thumbnails and analysis
+    all read through the same cache, so a source sample crosses the ARA interface at most once while
+    it is hot. Reading is thread safe; sources are registered (and listened to) on the message thread
+    through createReader().
+*/
+class AudioSourceBlockCache : private juce::ARAAudioSource::Listener
+{
+public:
+    static constexpr int blockSize = 32768; ///< Samples per channel in one block.
+
+    using Block = juce::AudioBuffer<float>;
+
+    explicit AudioSourceBlockCache (size_t memoryBudgetBytes = 256 * 1024 * 1024);
+    ~AudioSourceBlockCache() override;
+
+    /** Message thread only: makes the source readable through this cache. */
+    void addAudioSource (juce::ARAAudioSource* audioSource);
+
+    /** Message thread only: a reader of the source that goes through this cache. */
+    std::unique_ptr<juce::AudioFormatReader> createReader (juce::ARAAudioSource* audioSource);
+
+    /** Copies numSamples samples from startSample on into dest, one pointer per channel. Samples
+        outside the source read as silence. Returns false (with silence) if the source isn't
+        registered or the host couldn't deliver the samples. Without fetchMissing, blocks that
+        aren't cached yet aren't read from the host either, and also count as a failure. */
+    bool read (juce::ARAAudioSource* audioSource, float* const* dest, int numDestChannels,
+               int startOffsetInDest, juce::int64 startSample, int numSamples, bool fetchMissing = true);
+
+    /** A block of the source, read from the host into the cache unless it's there already;
+        nullptr if the source isn't registered or the host couldn't deliver the samples. */
+    std::shared_ptr<const Block> fetchBlock (juce::ARAAudioSource* audioSource, juce::int64 blockIndex);
+
+    /** Changes whenever the samples of any source change or a source goes away, so that blocks
+        held outside the cache can be checked without taking its lock. */
+    juce::uint32 getContentGeneration() const { return contentGeneration.load(); }
+
+    size_t getMemoryUsage() const;
+
+private:
+    using BlockKey = std::pair<juce::ARAAudioSource*, juce::int64>;
+
+    struct Source
+    {
+        explicit Source (juce::ARAAudioSource* audioSource)
+            : reader (audioSource), sampleCount (audioSource->getSampleCount()) {}
+
+        juce::ARAAudioSourceReader reader;
+        const juce::int64 sampleCount;
+        std::mutex fetchLock; ///< One host read per source at a time, so no block is fetched twice.
+        juce::uint32 generation = 0; ///< Guarded by the cache's lock; bumped whenever the host changes the samples.
+    };
+
+    struct Entry
+    {
+        std::shared_ptr<const Block> block;
+        std::list<BlockKey>::iterator lruPosition;
+    };
+
+    std::shared_ptr<Source> findSource (juce::ARAAudioSource* audioSource) const;
+    std::shared_ptr<const Block> getBlock (const std::shared_ptr<Source>& source, const BlockKey& key, bool fetchMissing);
+    std::shared_ptr<const Block> findBlock (const BlockKey& key);
+    void insertBlock (const BlockKey& key, std::shared_ptr<const Block> block);
+    void removeBlocks (juce::ARAAudioSource* audioSource);
+
+    void doUpdateAudioSourceContent (juce::ARAAudioSource* audioSource, juce::ARAContentUpdateScopes scopeFlags) override;
+    void willDestroyAudioSource (juce::ARAAudioSource* audioSource) override;
+
+    const size_t memoryBudget;
+
+    mutable std::mutex lock; ///< Guards everything below.
+    std::map<juce::ARAAudioSource*, std::shared_ptr<Source>> sources;
+    std::map<BlockKey, Entry> blocks;
+    std::list<BlockKey> leastRecentlyUsed; ///< Most recently used first.
+    size_t memoryUsage = 0;
+    std::atomic<juce::uint32> contentGeneration { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioSourceBlockCache)
+};
+
+//==============================================================================
+/** An AudioFormatReader of an ARA audio source that reads through an AudioSourceBlockCache. */
+class CachedAudioSourceReader : public juce::AudioFormatReader
+{
+public:
+    CachedAudioSourceReader (AudioSourceBlockCache& cacheIn, juce::ARAAudioSource* audioSourceIn);
+
+    bool readSamples (int* const* destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                      juce::int64 startSampleInFile, int numSamples) override;
+
+private:
+    AudioSourceBlockCache& cache;
+    juce::ARAAudioSource* audioSource;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CachedAudioSourceReader)
+};
 